@@ -0,0 +1,137 @@
+/**
+ * @file lpa.c
+ * @copyright Copyright (C) 2019 Ludovic Capelli
+ * @par License
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ * @author Ludovic Capelli
+ * @brief Label propagation: every vertex adopts the label most frequent among
+ * its neighbours, the smallest one in case of a tie. It needs every label
+ * received, so it runs on the version without combiner.
+ **/
+#include <stdlib.h>
+#include <inttypes.h>
+
+/*
+ * Line commented so that the vertex ID can be set to 4B or 8B ints at compile
+ * time and therefore generate two versions of this binary so that switching
+ * between the two no longer requires a recompilation.
+ * typedef uint64_t IP_VERTEX_ID_TYPE;
+ */
+typedef IP_VERTEX_ID_TYPE IP_NEIGHBOUR_COUNT_TYPE;
+typedef IP_VERTEX_ID_TYPE IP_MESSAGE_TYPE;
+typedef IP_VERTEX_ID_TYPE IP_VALUE_TYPE;
+#include "iPregel.h"
+
+unsigned int ROUND;
+/// The labels received by the vertex being computed, reused from one vertex to the next.
+IP_MESSAGE_TYPE* labels = NULL;
+/// The capacity of labels.
+size_t labels_max_size = 0;
+#pragma omp threadprivate(labels, labels_max_size)
+
+int compare_labels(const void* a, const void* b)
+{
+	IP_MESSAGE_TYPE label_a = *(const IP_MESSAGE_TYPE*)a;
+	IP_MESSAGE_TYPE label_b = *(const IP_MESSAGE_TYPE*)b;
+	return (label_a > label_b) - (label_a < label_b);
+}
+
+void ip_compute(struct ip_vertex_t* v)
+{
+	if(ip_is_first_superstep())
+	{
+		v->value = v->id;
+	}
+	else
+	{
+		size_t labels_count = 0;
+		IP_MESSAGE_TYPE label;
+		while(ip_get_next_message(v, &label))
+		{
+			if(labels_count == labels_max_size)
+			{
+				labels_max_size = labels_max_size == 0 ? 64 : labels_max_size * 2;
+				labels = ip_safe_realloc(labels, sizeof(IP_MESSAGE_TYPE) * labels_max_size);
+			}
+			labels[labels_count] = label;
+			labels_count++;
+		}
+
+		if(labels_count > 0)
+		{
+			// Once sorted, the first longest run holds the smallest of the most frequent labels.
+			qsort(labels, labels_count, sizeof(IP_MESSAGE_TYPE), compare_labels);
+			size_t best_run = 0;
+			size_t run_start = 0;
+			for(size_t i = 1; i <= labels_count; i++)
+			{
+				if(i == labels_count || labels[i] != labels[run_start])
+				{
+					if(i - run_start > best_run)
+					{
+						best_run = i - run_start;
+						v->value = labels[run_start];
+					}
+					run_start = i;
+				}
+			}
+		}
+	}
+
+	if(ip_get_superstep() < ROUND)
+	{
+		ip_broadcast(v, v->value);
+	}
+	ip_vote_to_halt(v);
+}
+
+void ip_serialise_vertex(FILE* f, struct ip_vertex_t* v)
+{
+	fprintf(f, "%" PRIu64 "\t%" PRIu64 "\n", (uint64_t)v->id, (uint64_t)v->value);
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc != 7)
+	{
+		printf("Incorrect number of parameters, expecting: %s <inputFile> <outputFile> <number_of_threads> <schedule> <chunk_size> <number_of_iterations>.\n", argv[0]);
+		return -1;
+	}
+
+	printf("ApplicationConfiguration:maxSuperstepCount=%u\n", atoi(argv[6]));
+
+	////////////////////
+	// INITILISATION //
+	//////////////////
+	bool directed = false;
+	bool weighted = false;
+	ROUND = atoi(argv[6]);
+	ip_init(argv[1], atoi(argv[3]), argv[4], atoi(argv[5]), directed, weighted);
+
+	//////////
+	// RUN //
+	////////
+	ip_run();
+
+	//////////////
+	// DUMPING //
+	////////////
+	FILE* f_out = fopen(argv[2], "wa");
+	if(!f_out)
+	{
+		perror("File opening failed.");
+		return -1;
+	}
+	ip_dump(f_out);
+
+	return EXIT_SUCCESS;
+}
@@ -27,11 +27,19 @@ typedef IP_VERTEX_ID_TYPE IP_NEIGHBOUR_COUNT_TYPE;
 typedef double IP_MESSAGE_TYPE;
 typedef IP_MESSAGE_TYPE IP_VALUE_TYPE;
 #define IP_NEEDS_OUT_NEIGHBOUR_COUNT
+// The sum combiner leaves any message unchanged when combined with 0.
+#define IP_COMBINER_IDENTITY 0.0
+// Lets the engine add messages itself instead of calling ip_combine.
+#define IP_COMBINER_FLOATING_SUM
 #include "iPregel.h"
 
 double ratio;
 double initial_value;
 unsigned int ROUND;
+/// The computation stops once the sum of the value changes of a superstep drops below this threshold.
+double residual_threshold = 0.0;
+/// The aggregator summing the value changes of every superstep.
+size_t residual_aggregator;
 
 void ip_compute(struct ip_vertex_t* v)
 {
@@ -49,10 +57,13 @@ void ip_compute(struct ip_vertex_t* v)
 		}
 
 		value_temp = ratio + 0.85 * sum;
+		ip_aggregate(residual_aggregator, value_temp > v->value ? value_temp - v->value : v->value - value_temp);
 		v->value = value_temp;
 	}
 
-	if(ip_get_superstep() < ROUND)
+	// Superstep 1 is the first one to aggregate a residual, it can be read from superstep 2.
+	bool converged = ip_get_superstep() > 1 && ip_get_aggregated_value(residual_aggregator) < residual_threshold;
+	if(ip_get_superstep() < ROUND && !converged)
 	{
 		if(v->out_neighbour_count > 0)
 		{
@@ -77,13 +88,18 @@ void ip_serialise_vertex(FILE* f, struct ip_vertex_t* v)
 
 int main(int argc, char* argv[])
 {
-	if(argc != 7) 
+	if(argc != 7 && argc != 8) 
 	{
-		printf("Incorrect number of parameters, expecting: %s <inputFile> <outputFile> <number_of_threads> <schedule> <chunk_size> <number_of_iterations>.\n", argv[0]);
+		printf("Incorrect number of parameters, expecting: %s <inputFile> <outputFile> <number_of_threads> <schedule> <chunk_size> <number_of_iterations> [<residual_threshold>].\n", argv[0]);
 		return -1;
 	}
 
+	if(argc == 8)
+	{
+		residual_threshold = atof(argv[7]);
+	}
 	printf("ApplicationConfiguration:maxSuperstepCount=%u\n", atoi(argv[6]));
+	printf("ApplicationConfiguration:residualThreshold=%f\n", residual_threshold);
 
 	////////////////////
 	// INITILISATION //
@@ -92,6 +108,7 @@ int main(int argc, char* argv[])
 	bool weighted = false;
 	ROUND = atoi(argv[6]);
 	ip_init(argv[1], atoi(argv[3]), argv[4], atoi(argv[5]), directed, weighted);
+	residual_aggregator = ip_register_aggregator(IP_AGGREGATOR_SUM);
 
 	//////////
 	// RUN //
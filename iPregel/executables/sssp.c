@@ -29,6 +29,10 @@
 typedef IP_VERTEX_ID_TYPE IP_NEIGHBOUR_COUNT_TYPE;
 typedef IP_VERTEX_ID_TYPE IP_MESSAGE_TYPE;
 typedef IP_VERTEX_ID_TYPE IP_VALUE_TYPE;
+// The minimum combiner leaves any message unchanged when combined with the largest value.
+#define IP_COMBINER_IDENTITY ((IP_MESSAGE_TYPE)-1)
+// Lets the engine combine messages with its own minimum instead of calling ip_combine.
+#define IP_COMBINER_MIN
 #include "iPregel.h"
 // For reference DBLP, start_vertex=0
 // For reference liveJournal, start_vertex=0
@@ -0,0 +1,551 @@
+/**
+ * @file combiner_asynchronous_postamble.h
+ * @copyright Copyright (C) 2019 Ludovic Capelli
+ * @par License
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ * @author Ludovic Capelli
+ **/
+
+#ifndef COMBINER_ASYNCHRONOUS_POSTAMBLE_H_INCLUDED
+#define COMBINER_ASYNCHRONOUS_POSTAMBLE_H_INCLUDED
+
+#include <omp.h>
+#include <string.h>
+
+bool ip_has_message(struct ip_vertex_t* v)
+{
+	return v->has_message;
+}
+
+bool ip_get_next_message(struct ip_vertex_t* v, IP_MESSAGE_TYPE* message_value)
+{
+	if(v->has_message)
+	{
+		*message_value = v->message;
+		v->has_message = false;
+		return true;
+	}
+
+	return false;
+}
+
+void ip_send_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
+{
+	struct ip_vertex_t* temp_vertex = ip_get_vertex_by_id(id);
+	// A message that leaves the mailbox unchanged brings nothing new, whoever changed the mailbox last has scheduled the vertex.
+	if(ip_cas(&temp_vertex->mailbox, message))
+	{
+		ip_schedule_vertex(temp_vertex);
+	}
+}
+
+void ip_broadcast(struct ip_vertex_t* v, IP_MESSAGE_TYPE message)
+{
+	for(IP_NEIGHBOUR_COUNT_TYPE i = 0; i < v->out_neighbour_count; i++)
+	{
+		ip_send_message(v->out_neighbours[i], message);
+	}
+}
+
+void ip_schedule_vertex(struct ip_vertex_t* v)
+{
+	unsigned char state = atomic_load(&v->state);
+	while(true)
+	{
+		if(state == IP_VERTEX_IDLE)
+		{
+			if(atomic_compare_exchange_strong(&v->state, &state, IP_VERTEX_QUEUED))
+			{
+				ip_push_vertex(v);
+				return;
+			}
+		}
+		else if(state == IP_VERTEX_RUNNING)
+		{
+			if(atomic_compare_exchange_strong(&v->state, &state, IP_VERTEX_RUNNING_AGAIN))
+			{
+				return;
+			}
+		}
+		#ifdef IP_USE_PRIORITY_BUCKETS
+			else if(state == IP_VERTEX_QUEUED)
+			{
+				// The priority may have dropped below that of the bucket holding the vertex, the vertex is queued again and whichever copy is popped first executes it.
+				ip_push_vertex(v);
+				return;
+			}
+		#endif // ifdef IP_USE_PRIORITY_BUCKETS
+		else
+		{
+			// Already queued, or already flagged to run again.
+			return;
+		}
+	}
+}
+
+void ip_lock_shared_worklist(struct ip_thread_context_t* context)
+{
+	while(atomic_exchange_explicit(&context->shared_worklist_lock, true, memory_order_acquire))
+	{
+		while(atomic_load_explicit(&context->shared_worklist_lock, memory_order_relaxed))
+		{
+		}
+	}
+}
+
+void ip_unlock_shared_worklist(struct ip_thread_context_t* context)
+{
+	atomic_store_explicit(&context->shared_worklist_lock, false, memory_order_release);
+}
+
+void ip_reserve_worklist(struct ip_worklist_t* worklist, size_t size)
+{
+	if(worklist->max_size < size)
+	{
+		worklist->max_size = worklist->max_size * 2 < size ? size : worklist->max_size * 2;
+		worklist->data = ip_safe_realloc(worklist->data, sizeof(struct ip_vertex_t*) * worklist->max_size);
+	}
+}
+
+void ip_push_private_vertex(struct ip_thread_context_t* context, struct ip_vertex_t* v)
+{
+	struct ip_worklist_t* worklist = &context->private_worklist;
+	#ifdef IP_USE_PRIORITY_BUCKETS
+		size_t bucket = ip_get_vertex_priority(v) / IP_PRIORITY_DELTA;
+		if(bucket < context->first_bucket + context->current_bucket)
+		{
+			// Buckets below the current one have been emptied already, the vertex runs with the current bucket.
+			worklist = &context->priority_buckets[context->current_bucket];
+		}
+		else if(bucket - context->first_bucket < IP_PRIORITY_BUCKETS_COUNT)
+		{
+			worklist = &context->priority_buckets[bucket - context->first_bucket];
+		}
+		context->private_vertices_count++;
+	#else // ifndef IP_USE_PRIORITY_BUCKETS
+		if(worklist->size == worklist->max_size && context->private_worklist_first > 0 && context->private_worklist_first >= worklist->size / 2)
+		{
+			// Reclaim the space of the vertices popped already rather than growing the buffer.
+			worklist->size -= context->private_worklist_first;
+			memmove(worklist->data, &worklist->data[context->private_worklist_first], sizeof(struct ip_vertex_t*) * worklist->size);
+			context->private_worklist_first = 0;
+		}
+	#endif // if(n)def IP_USE_PRIORITY_BUCKETS
+	ip_reserve_worklist(worklist, worklist->size + 1);
+	worklist->data[worklist->size] = v;
+	worklist->size++;
+}
+
+struct ip_vertex_t* ip_pop_private_vertex(struct ip_thread_context_t* context)
+{
+	#ifdef IP_USE_PRIORITY_BUCKETS
+		if(context->private_vertices_count == 0)
+		{
+			return NULL;
+		}
+		while(context->priority_buckets[context->current_bucket].size == 0)
+		{
+			context->current_bucket++;
+			if(context->current_bucket == IP_PRIORITY_BUCKETS_COUNT)
+			{
+				// The remaining vertices are all in the overflow worklist.
+				ip_refill_priority_buckets(context);
+			}
+		}
+		struct ip_worklist_t* worklist = &context->priority_buckets[context->current_bucket];
+		context->private_vertices_count--;
+		worklist->size--;
+		return worklist->data[worklist->size];
+	#else // ifndef IP_USE_PRIORITY_BUCKETS
+		// Vertices are executed in the order they were queued; executing the latest first would relax long paths before short ones.
+		struct ip_worklist_t* worklist = &context->private_worklist;
+		if(context->private_worklist_first == worklist->size)
+		{
+			return NULL;
+		}
+		struct ip_vertex_t* v = worklist->data[context->private_worklist_first];
+		context->private_worklist_first++;
+		if(context->private_worklist_first == worklist->size)
+		{
+			context->private_worklist_first = 0;
+			worklist->size = 0;
+		}
+		return v;
+	#endif // if(n)def IP_USE_PRIORITY_BUCKETS
+}
+
+size_t ip_get_private_vertices_count(struct ip_thread_context_t* context)
+{
+	#ifdef IP_USE_PRIORITY_BUCKETS
+		return context->private_vertices_count;
+	#else // ifndef IP_USE_PRIORITY_BUCKETS
+		return context->private_worklist.size - context->private_worklist_first;
+	#endif // if(n)def IP_USE_PRIORITY_BUCKETS
+}
+
+#ifdef IP_USE_PRIORITY_BUCKETS
+	size_t ip_get_vertex_priority(struct ip_vertex_t* v)
+	{
+		IP_MESSAGE_TYPE message;
+		#ifdef IP_COMPOSITE_MESSAGES
+			if(IP_MESSAGE_CAS_ABLE)
+			{
+				__atomic_load(&v->mailbox, &message, __ATOMIC_RELAXED);
+			}
+			else
+			{
+				struct ip_message_lock_t* lock = ip_lock_mailbox(&v->mailbox);
+				message = v->mailbox;
+				ip_unlock_mailbox(lock);
+			}
+		#else // ifndef IP_COMPOSITE_MESSAGES
+			message = atomic_load_explicit(&v->mailbox, memory_order_relaxed);
+		#endif // if(n)def IP_COMPOSITE_MESSAGES
+		return IP_MESSAGE_PRIORITY(message);
+	}
+
+	void ip_refill_priority_buckets(struct ip_thread_context_t* context)
+	{
+		struct ip_worklist_t* overflow = &context->private_worklist;
+		// Priorities are read again, they may have decreased since the vertices were queued.
+		size_t lowest_bucket = ip_get_vertex_priority(overflow->data[0]) / IP_PRIORITY_DELTA;
+		for(size_t i = 1; i < overflow->size; i++)
+		{
+			size_t bucket = ip_get_vertex_priority(overflow->data[i]) / IP_PRIORITY_DELTA;
+			if(bucket < lowest_bucket)
+			{
+				lowest_bucket = bucket;
+			}
+		}
+
+		context->first_bucket = lowest_bucket;
+		context->current_bucket = 0;
+		size_t overflow_size = overflow->size;
+		overflow->size = 0;
+		for(size_t i = 0; i < overflow_size; i++)
+		{
+			// The overflow worklist is compacted in place, vertices only move towards its start.
+			ip_push_private_vertex(context, overflow->data[i]);
+		}
+		context->private_vertices_count -= overflow_size;
+	}
+#endif // ifdef IP_USE_PRIORITY_BUCKETS
+
+void ip_push_vertex(struct ip_vertex_t* v)
+{
+	struct ip_thread_context_t* my_context = &ip_all_thread_contexts[ip_my_thread_num];
+	ip_push_private_vertex(my_context, v);
+
+	// Share a batch only when other threads ran out of what was shared before, so the lock is rarely taken.
+	if(ip_get_private_vertices_count(my_context) >= 2 * IP_ASYNCHRONOUS_SHARING_BATCH && atomic_load_explicit(&my_context->shared_worklist_size, memory_order_relaxed) == 0)
+	{
+		ip_lock_shared_worklist(my_context);
+		struct ip_worklist_t* shared_worklist = &my_context->shared_worklist;
+		ip_reserve_worklist(shared_worklist, shared_worklist->size + IP_ASYNCHRONOUS_SHARING_BATCH);
+		for(size_t i = 0; i < IP_ASYNCHRONOUS_SHARING_BATCH; i++)
+		{
+			shared_worklist->data[shared_worklist->size] = ip_pop_private_vertex(my_context);
+			shared_worklist->size++;
+		}
+		atomic_store_explicit(&my_context->shared_worklist_size, shared_worklist->size, memory_order_relaxed);
+		ip_unlock_shared_worklist(my_context);
+	}
+}
+
+struct ip_vertex_t* ip_pop_vertex()
+{
+	struct ip_thread_context_t* my_context = &ip_all_thread_contexts[ip_my_thread_num];
+	struct ip_vertex_t* v = ip_pop_private_vertex(my_context);
+	// The calling thread looks at its own shared worklist first, then at those of the other threads.
+	for(int i = 0; i < ip_thread_count && v == NULL; i++)
+	{
+		struct ip_thread_context_t* victim = &ip_all_thread_contexts[(ip_my_thread_num + i) % ip_thread_count];
+		if(atomic_load_explicit(&victim->shared_worklist_size, memory_order_relaxed) > 0)
+		{
+			ip_lock_shared_worklist(victim);
+			struct ip_worklist_t* shared_worklist = &victim->shared_worklist;
+			// The owner takes everything back, a thief takes half.
+			size_t taken = i == 0 ? shared_worklist->size : (shared_worklist->size + 1) / 2;
+			for(size_t j = 0; j < taken; j++)
+			{
+				shared_worklist->size--;
+				ip_push_private_vertex(my_context, shared_worklist->data[shared_worklist->size]);
+			}
+			atomic_store_explicit(&victim->shared_worklist_size, shared_worklist->size, memory_order_relaxed);
+			ip_unlock_shared_worklist(victim);
+			v = ip_pop_private_vertex(my_context);
+		}
+	}
+
+	return v;
+}
+
+void ip_execute_vertex(struct ip_vertex_t* v)
+{
+	unsigned char state = IP_VERTEX_QUEUED;
+	if(!atomic_compare_exchange_strong(&v->state, &state, IP_VERTEX_RUNNING))
+	{
+		// Another copy of the vertex was executed already.
+		return;
+	}
+	while(true)
+	{
+		// Read the messages combined so far, the senders that come after will flag the vertex to run again.
+		IP_MESSAGE_TYPE latest_message;
+		#ifdef IP_COMPOSITE_MESSAGES
+			if(IP_MESSAGE_CAS_ABLE)
+			{
+				__atomic_load(&v->mailbox, &latest_message, __ATOMIC_SEQ_CST);
+			}
+			else
+			{
+				struct ip_message_lock_t* lock = ip_lock_mailbox(&v->mailbox);
+				latest_message = v->mailbox;
+				ip_unlock_mailbox(lock);
+			}
+			v->has_message = memcmp(&latest_message, &v->message, sizeof(IP_MESSAGE_TYPE)) != 0;
+		#else
+			latest_message = atomic_load(&v->mailbox);
+			v->has_message = latest_message != v->message;
+		#endif // ifdef IP_COMPOSITE_MESSAGES
+		v->message = latest_message;
+
+		v->active = true;
+		ip_compute(v);
+		ip_all_thread_contexts[ip_my_thread_num].executions_count++;
+		if(v->active)
+		{
+			// The vertex did not vote to halt, it is executed again later whether it receives messages or not.
+			atomic_store(&v->state, IP_VERTEX_QUEUED);
+			ip_push_vertex(v);
+			return;
+		}
+
+		state = IP_VERTEX_RUNNING;
+		if(atomic_compare_exchange_strong(&v->state, &state, IP_VERTEX_IDLE))
+		{
+			return;
+		}
+		// Messages arrived during the execution.
+		atomic_store(&v->state, IP_VERTEX_RUNNING);
+	}
+}
+
+void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
+{
+	for(IP_VERTEX_ID_TYPE i = first; i <= last; i++)
+	{
+		ip_all_vertices[i].id = i;
+		ip_all_vertices[i].active = true;
+		ip_all_vertices[i].has_message = false;
+		atomic_init(&ip_all_vertices[i].state, IP_VERTEX_IDLE);
+		ip_all_vertices[i].mailbox = IP_COMBINER_IDENTITY;
+		ip_all_vertices[i].message = IP_COMBINER_IDENTITY;
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+			ip_all_vertices[i].out_neighbour_count = 0;
+		#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_IDS
+			ip_all_vertices[i].out_neighbours = NULL;
+		#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_IDS
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+			ip_all_vertices[i].out_neighbour_weights = NULL;
+		#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+			ip_all_vertices[i].in_neighbours = NULL;
+		#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_COUNT
+			ip_all_vertices[i].in_neighbour_count = 0;
+		#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_COUNT
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+			ip_all_vertices[i].in_neighbour_weights = NULL;
+		#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHT
+	}
+}
+
+void ip_init_thread_context(struct ip_thread_context_t* context)
+{
+	context->private_worklist.max_size = 0;
+	context->private_worklist.size = 0;
+	context->private_worklist.data = NULL;
+	#ifdef IP_USE_PRIORITY_BUCKETS
+		for(size_t i = 0; i < IP_PRIORITY_BUCKETS_COUNT; i++)
+		{
+			context->priority_buckets[i].max_size = 0;
+			context->priority_buckets[i].size = 0;
+			context->priority_buckets[i].data = NULL;
+		}
+		context->first_bucket = 0;
+		context->current_bucket = 0;
+		context->private_vertices_count = 0;
+	#else // ifndef IP_USE_PRIORITY_BUCKETS
+		context->private_worklist_first = 0;
+	#endif // if(n)def IP_USE_PRIORITY_BUCKETS
+	context->executions_count = 0;
+	atomic_init(&context->shared_worklist_lock, false);
+	atomic_init(&context->shared_worklist_size, 0);
+	context->shared_worklist.max_size = 0;
+	context->shared_worklist.size = 0;
+	context->shared_worklist.data = NULL;
+}
+
+void ip_init_specific()
+{
+}
+
+int ip_run()
+{
+	double timer_superstep_start = 0;
+	double timer_superstep_stop = 0;
+	double timer_asynchronous_start = 0;
+	double timer_asynchronous_stop = 0;
+
+	#pragma omp parallel default(none) shared(ip_active_vertices, \
+											  ip_use_edge_stealing, \
+											  ip_idle_threads, \
+											  ip_all_thread_contexts, \
+											  ip_thread_count, \
+											  timer_superstep_start, \
+											  timer_superstep_stop, \
+											  timer_asynchronous_start, \
+											  timer_asynchronous_stop)
+	{
+		ip_my_thread_num = omp_get_thread_num();
+
+		/////////////////
+		// SUPERSTEP 0 //
+		/////////////////
+		// Every vertex is executed once; messages delivered meanwhile queue their recipients, which are only executed afterwards.
+		#pragma omp single
+		{
+			timer_superstep_start = omp_get_wtime();
+		}
+		if(ip_use_edge_stealing)
+		{
+			size_t chunk_first;
+			size_t chunk_last;
+			ip_prepare_chunks(NULL, ip_get_vertices_count());
+			while(ip_get_next_chunk(&chunk_first, &chunk_last))
+			{
+				for(size_t i = chunk_first; i < chunk_last; i++)
+				{
+					struct ip_vertex_t* temp_vertex = ip_get_vertex_by_location(i);
+					ip_compute(temp_vertex);
+					if(temp_vertex->active)
+					{
+						ip_schedule_vertex(temp_vertex);
+					}
+				}
+			}
+			// Replaces the implicit barrier of the OpenMP for below.
+			#pragma omp barrier
+		}
+		else
+		{
+			#pragma omp for schedule(runtime)
+			for(size_t i = 0; i < ip_get_vertices_count(); i++)
+			{
+				struct ip_vertex_t* temp_vertex = ip_get_vertex_by_location(i);
+				ip_compute(temp_vertex);
+				if(temp_vertex->active)
+				{
+					ip_schedule_vertex(temp_vertex);
+				}
+			}
+		}
+
+		#pragma omp single
+		{
+			ip_active_vertices = 0;
+			for(int i = 0; i < ip_thread_count; i++)
+			{
+				ip_active_vertices += ip_get_private_vertices_count(&ip_all_thread_contexts[i]) + ip_all_thread_contexts[i].shared_worklist.size;
+			}
+			timer_superstep_stop = omp_get_wtime();
+			printf("Superstep%zuDuration:%f\n", ip_get_superstep(), timer_superstep_stop - timer_superstep_start);
+			printf("Superstep%zuActiveVertexCount:%zu\n", ip_get_superstep(), ip_active_vertices);
+			ip_reduce_aggregators();
+			ip_increment_superstep();
+			timer_asynchronous_start = omp_get_wtime();
+		}
+
+		////////////////////////
+		// ASYNCHRONOUS PHASE //
+		////////////////////////
+		while(true)
+		{
+			struct ip_vertex_t* temp_vertex = ip_pop_vertex();
+			if(temp_vertex != NULL)
+			{
+				ip_execute_vertex(temp_vertex);
+			}
+			else
+			{
+				// An idle thread never queues vertices, so once all threads are idle there is nothing left to do.
+				atomic_fetch_add(&ip_idle_threads, 1);
+				bool work_found = false;
+				while(!work_found && atomic_load(&ip_idle_threads) < ip_thread_count)
+				{
+					for(int i = 0; i < ip_thread_count && !work_found; i++)
+					{
+						work_found = atomic_load_explicit(&ip_all_thread_contexts[i].shared_worklist_size, memory_order_relaxed) > 0;
+					}
+				}
+				if(!work_found)
+				{
+					break;
+				}
+				atomic_fetch_sub(&ip_idle_threads, 1);
+			}
+		}
+
+		#pragma omp barrier
+		#pragma omp single
+		{
+			size_t executions_count = 0;
+			for(int i = 0; i < ip_thread_count; i++)
+			{
+				executions_count += ip_all_thread_contexts[i].executions_count;
+			}
+			atomic_store(&ip_idle_threads, 0);
+			ip_active_vertices = 0;
+			timer_asynchronous_stop = omp_get_wtime();
+			printf("AsynchronousPhaseDuration:%f\n", timer_asynchronous_stop - timer_asynchronous_start);
+			printf("AsynchronousVertexExecutionCount:%zu\n", executions_count);
+			ip_reduce_aggregators();
+		} // End of OpenMP single region
+ 	} // End of OpenMP region
+
+	printf("Total time of supersteps: %fs.\n", (timer_superstep_stop - timer_superstep_start) + (timer_asynchronous_stop - timer_asynchronous_start));
+
+	// Free and clean program.
+	#pragma omp parallel
+	{
+		struct ip_thread_context_t* my_context = &ip_all_thread_contexts[omp_get_thread_num()];
+		ip_safe_free(my_context->private_worklist.data);
+		ip_safe_free(my_context->shared_worklist.data);
+		#ifdef IP_USE_PRIORITY_BUCKETS
+			for(size_t i = 0; i < IP_PRIORITY_BUCKETS_COUNT; i++)
+			{
+				ip_safe_free(my_context->priority_buckets[i].data);
+			}
+		#endif // ifdef IP_USE_PRIORITY_BUCKETS
+	}
+
+	return 0;
+}
+
+void ip_vote_to_halt(struct ip_vertex_t* v)
+{
+	v->active = false;
+}
+
+#endif // COMBINER_ASYNCHRONOUS_POSTAMBLE_H_INCLUDED
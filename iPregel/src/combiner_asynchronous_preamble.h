@@ -0,0 +1,276 @@
+/**
+ * @file combiner_asynchronous_preamble.h
+ * @copyright Copyright (C) 2019 Ludovic Capelli
+ * @par License
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ * @author Ludovic Capelli
+ * @brief This version executes vertices asynchronously, without supersteps.
+ * @details This version is meant for monotone combiners, such as the minimum
+ * used by connected components or single-source shortest paths, for which a
+ * message can be consumed as soon as it is delivered. After a synchronous
+ * superstep 0, a vertex whose mailbox changes is pushed to the worklist of the
+ * sending thread and executed as soon as a thread gets to it, which propagates
+ * updates within what would otherwise be a single superstep. The execution
+ * ends when all worklists are empty and all threads are idle.
+ * - ip_get_superstep() returns 0 during the first pass over all vertices and 1
+ * afterwards, so applications must not rely on the superstep number beyond
+ * ip_is_first_superstep().
+ * - the mailbox of a vertex combines all the messages it receives during the
+ * whole execution, and the vertex receives the combination each time it
+ * changed since the last execution. A message that does not improve on what
+ * the mailbox holds, such as a distance larger than one received before,
+ * therefore triggers no execution.
+ * - IP_COMBINER_IDENTITY must be defined: mailboxes start with the identity,
+ * and a vertex has no message until its mailbox differs from it.
+ * When IP_USE_PRIORITY_BUCKETS is defined, the private worklist of a thread is
+ * split into buckets of priority, delta-stepping style, and the thread always
+ * executes a vertex of its lowest non-empty bucket. The priority of a vertex is
+ * IP_MESSAGE_PRIORITY applied to its mailbox when it is queued, so that with a
+ * minimum combiner the vertices with the smallest distances run first, which
+ * saves the relaxations that a larger distance would trigger in vain. Only
+ * IP_PRIORITY_BUCKETS_COUNT buckets are kept, those beyond are held in an
+ * overflow worklist until the buckets run out.
+ **/
+
+#ifndef COMBINER_ASYNCHRONOUS_PREAMBLE_H_INCLUDED
+#define COMBINER_ASYNCHRONOUS_PREAMBLE_H_INCLUDED
+
+#ifndef IP_COMBINER_IDENTITY
+	#error The asynchronous version requires IP_COMBINER_IDENTITY to be defined.
+#endif // ifndef IP_COMBINER_IDENTITY
+
+#if defined(IP_COMBINER_SUM) || defined(IP_COMBINER_FLOATING_SUM)
+	#error The asynchronous version requires a monotone combiner such as a minimum or a maximum, a sum never stops changing the mailboxes.
+#endif // if defined(IP_COMBINER_SUM) || defined(IP_COMBINER_FLOATING_SUM)
+
+#ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
+	#define IP_NEEDS_OUT_NEIGHBOUR_IDS
+#endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
+
+#ifndef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+	#define IP_NEEDS_OUT_NEIGHBOUR_COUNT
+#endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+
+#ifndef IP_ASYNCHRONOUS_SHARING_BATCH
+	/// The number of vertices a thread moves from its private worklist to its shared one, where other threads can steal them.
+	#define IP_ASYNCHRONOUS_SHARING_BATCH 64
+#endif // ifndef IP_ASYNCHRONOUS_SHARING_BATCH
+
+#ifdef IP_USE_PRIORITY_BUCKETS
+	#ifndef IP_PRIORITY_DELTA
+		/// The range of priorities covered by a bucket.
+		#define IP_PRIORITY_DELTA 1
+	#endif // ifndef IP_PRIORITY_DELTA
+
+	#ifndef IP_PRIORITY_BUCKETS_COUNT
+		/// The number of consecutive buckets a thread keeps before resorting to its overflow worklist.
+		#define IP_PRIORITY_BUCKETS_COUNT 64
+	#endif // ifndef IP_PRIORITY_BUCKETS_COUNT
+
+	#ifndef IP_MESSAGE_PRIORITY
+		#ifdef IP_COMPOSITE_MESSAGES
+			#error IP_MESSAGE_PRIORITY must be defined to use priority buckets with composite messages.
+		#endif // ifdef IP_COMPOSITE_MESSAGES
+		/// Converts a message into a priority, the lower the sooner the recipient runs.
+		#define IP_MESSAGE_PRIORITY(message) ((size_t)(message))
+	#endif // ifndef IP_MESSAGE_PRIORITY
+#endif // ifdef IP_USE_PRIORITY_BUCKETS
+
+#include <stdatomic.h>
+
+// Global variables
+/// The states a vertex goes through during the asynchronous execution.
+enum ip_vertex_state_t
+{
+	/// The vertex is neither queued nor running.
+	IP_VERTEX_IDLE = 0,
+	/// The vertex is in a worklist.
+	IP_VERTEX_QUEUED,
+	/// A thread is executing the vertex.
+	IP_VERTEX_RUNNING,
+	/// A thread is executing the vertex, and its mailbox changed since it was read.
+	IP_VERTEX_RUNNING_AGAIN
+};
+/// This structure defines the structure of a vertex.
+struct ip_vertex_t
+{
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_IDS
+		/// Contains the identifiers of the out-neighbours
+		IP_VERTEX_ID_TYPE* out_neighbours;
+	#endif // IP_NEEDS_OUT_NEIGHBOUR_IDS
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+		/// Contains the identifiers of the in-neighbours
+		IP_VERTEX_ID_TYPE* in_neighbours;
+	#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+		/// Contains the number of out-neighbours
+		IP_NEIGHBOUR_COUNT_TYPE out_neighbour_count;
+	#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_COUNT
+		/// Contains the number of in-neighbours
+		IP_NEIGHBOUR_COUNT_TYPE in_neighbour_count;
+	#endif // IP_NEEDS_IN_NEIGHBOUR_COUNT
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+		/// Contains the weights of out-edges
+		IP_EDGE_WEIGHT_TYPE* out_neighbour_weights;
+	#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+		/// Contains the weights of the in-neighbours
+		IP_EDGE_WEIGHT_TYPE* in_neighbour_weights;
+	#endif // IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+	/// Contains the vertex status
+	bool active;
+	/// Indicates whether the mailbox changed since the previous execution and the vertex has not read it yet
+	bool has_message;
+	/// Contains the state of the vertex, see ip_vertex_state_t
+	atomic_uchar state;
+	/// Contains the vertex identifier
+	IP_VERTEX_ID_TYPE id;
+	/// Contains the combination of all messages received so far, IP_COMBINER_IDENTITY if none
+	IP_MESSAGE_TYPE mailbox;
+	/// Contains the combination of all messages received as of the last execution of the vertex
+	IP_MESSAGE_TYPE message;
+	/// Contains the user-defined value
+	IP_VALUE_TYPE value;
+};
+/// This structure holds a list of vertices to execute.
+struct ip_worklist_t
+{
+	/// The size of the memory buffer. It is used for reallocation purpose.
+	size_t max_size;
+	/// The number of vertices currently stored.
+	size_t size;
+	/// The actual vertices.
+	struct ip_vertex_t** data;
+};
+/// This structure holds the data that a thread uses during the execution.
+struct ip_thread_context_t
+{
+	/// The vertices to execute that only this thread accesses. With priority buckets, it holds the vertices beyond the last bucket.
+	_Alignas(IP_CACHE_LINE_SIZE) struct ip_worklist_t private_worklist;
+	#ifdef IP_USE_PRIORITY_BUCKETS
+		/// The vertices to execute that only this thread accesses, bucket i holding the priorities of bucket number first_bucket + i.
+		struct ip_worklist_t priority_buckets[IP_PRIORITY_BUCKETS_COUNT];
+		/// The bucket number of priority_buckets[0].
+		size_t first_bucket;
+		/// The index of the lowest bucket that may not be empty.
+		size_t current_bucket;
+		/// The number of vertices in the buckets and the overflow worklist.
+		size_t private_vertices_count;
+	#else // ifndef IP_USE_PRIORITY_BUCKETS
+		/// The position of the oldest vertex in the private worklist, which is popped first.
+		size_t private_worklist_first;
+	#endif // if(n)def IP_USE_PRIORITY_BUCKETS
+	/// The number of vertex executions done by this thread.
+	size_t executions_count;
+	/// Protects the shared worklist.
+	_Alignas(IP_CACHE_LINE_SIZE) atomic_bool shared_worklist_lock;
+	/// The number of vertices in the shared worklist, readable without taking the lock.
+	_Atomic size_t shared_worklist_size;
+	/// The vertices to execute that other threads may steal.
+	struct ip_worklist_t shared_worklist;
+};
+/// The number of threads that found no vertex to execute.
+_Atomic int ip_idle_threads = 0;
+
+/**
+ * @brief This function acquires the lock of the shared worklist of the thread
+ * whose context is \p context.
+ * @param[inout] context The context holding the shared worklist.
+ **/
+void ip_lock_shared_worklist(struct ip_thread_context_t* context);
+/**
+ * @brief This function releases the lock of the shared worklist of the thread
+ * whose context is \p context.
+ * @param[inout] context The context holding the shared worklist.
+ **/
+void ip_unlock_shared_worklist(struct ip_thread_context_t* context);
+/**
+ * @brief This function makes sure that the worklist \p worklist can hold
+ * \p size vertices.
+ * @param[inout] worklist The worklist to grow.
+ * @param[in] size The number of vertices to hold.
+ **/
+void ip_reserve_worklist(struct ip_worklist_t* worklist, size_t size);
+/**
+ * @brief This function adds the vertex \p v to the private worklist of the
+ * thread whose context is \p context.
+ * @param[inout] context The context of the calling thread.
+ * @param[in] v The vertex to add.
+ **/
+void ip_push_private_vertex(struct ip_thread_context_t* context, struct ip_vertex_t* v);
+/**
+ * @brief This function removes a vertex from the private worklist of the thread
+ * whose context is \p context.
+ * @details The vertex is the oldest in the worklist or, with priority
+ * buckets, one of the lowest non-empty bucket.
+ * @param[inout] context The context of the calling thread.
+ * @return The vertex removed, or NULL if the private worklist is empty.
+ **/
+struct ip_vertex_t* ip_pop_private_vertex(struct ip_thread_context_t* context);
+/**
+ * @brief This function gives the number of vertices in the private worklist of
+ * the thread whose context is \p context.
+ * @param[in] context The context of the thread.
+ * @return The number of vertices in the private worklist.
+ **/
+size_t ip_get_private_vertices_count(struct ip_thread_context_t* context);
+#ifdef IP_USE_PRIORITY_BUCKETS
+	/**
+	 * @brief This function gives the priority of the vertex \p v, obtained from
+	 * the messages combined in its mailbox.
+	 * @param[in] v The vertex.
+	 * @return The priority of \p v.
+	 **/
+	size_t ip_get_vertex_priority(struct ip_vertex_t* v);
+	/**
+	 * @brief This function moves the buckets of the thread whose context is
+	 * \p context to start at the lowest priority of the overflow worklist, and
+	 * moves into them the vertices of the overflow worklist they now cover.
+	 * @param[inout] context The context of the calling thread.
+	 * @pre All buckets are empty.
+	 **/
+	void ip_refill_priority_buckets(struct ip_thread_context_t* context);
+#endif // ifdef IP_USE_PRIORITY_BUCKETS
+/**
+ * @brief This function queues the vertex \p v unless it is queued already.
+ * @details If \p v is running, it is flagged so that it runs again with the
+ * messages that arrived meanwhile.
+ * @param[inout] v The vertex whose mailbox changed.
+ **/
+void ip_schedule_vertex(struct ip_vertex_t* v);
+/**
+ * @brief This function pushes the vertex \p v to the worklist of the calling
+ * thread.
+ * @details When the private worklist grows large and the shared one is empty,
+ * a batch of vertices is moved to the shared worklist for other threads.
+ * @param[in] v The vertex to push.
+ **/
+void ip_push_vertex(struct ip_vertex_t* v);
+/**
+ * @brief This function gives the calling thread the next vertex to execute.
+ * @details The vertex comes from the private worklist first, then from the
+ * shared worklist of the calling thread, then from that of other threads.
+ * @return The vertex to execute, or NULL if no vertex was found.
+ **/
+struct ip_vertex_t* ip_pop_vertex();
+/**
+ * @brief This function executes the vertex \p v until its mailbox no longer
+ * changes during its execution.
+ * @details With priority buckets, a vertex may be in several worklists at
+ * once; only the first copy popped executes it, the others return immediately.
+ * @param[inout] v The vertex to execute.
+ * @pre The calling thread popped \p v.
+ **/
+void ip_execute_vertex(struct ip_vertex_t* v);
+
+#endif // COMBINER_ASYNCHRONOUS_PREAMBLE_H_INCLUDED
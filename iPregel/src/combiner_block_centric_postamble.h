@@ -0,0 +1,319 @@
+/**
+ * @file combiner_block_centric_postamble.h
+ * @copyright Copyright (C) 2019 Ludovic Capelli
+ * @par License
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ * @author Ludovic Capelli
+ **/
+
+#ifndef COMBINER_BLOCK_CENTRIC_POSTAMBLE_H_INCLUDED
+#define COMBINER_BLOCK_CENTRIC_POSTAMBLE_H_INCLUDED
+
+#include <omp.h>
+#include <string.h>
+
+size_t ip_get_mailbox_slot(size_t superstep)
+{
+	return superstep % 2;
+}
+
+bool ip_has_message(struct ip_vertex_t* v)
+{
+	return atomic_load_explicit(&v->has_message[ip_get_mailbox_slot(ip_get_superstep())], memory_order_relaxed) == IP_MAILBOX_FULL;
+}
+
+bool ip_get_next_message(struct ip_vertex_t* v, IP_MESSAGE_TYPE* message_value)
+{
+	size_t slot = ip_get_mailbox_slot(ip_get_superstep());
+	if(atomic_load_explicit(&v->has_message[slot], memory_order_relaxed) == IP_MAILBOX_FULL)
+	{
+		*message_value = v->message[slot];
+		ip_empty_mailbox(&v->has_message[slot], &v->message[slot]);
+		return true;
+	}
+
+	return false;
+}
+
+void ip_send_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
+{
+	struct ip_vertex_t* temp_vertex = ip_get_vertex_by_id(id);
+	size_t location = temp_vertex - ip_get_vertex_by_location(0);
+	struct ip_thread_context_t* my_context = &ip_all_thread_contexts[ip_my_thread_num];
+	// At superstep 0, every vertex is executed once whatever it receives, so local messages wait for the next superstep too.
+	if(!ip_is_first_superstep() && location >= my_context->block_first && location < my_context->block_last)
+	{
+		// Only the calling thread executes the vertices of its block, no atomic operation is needed.
+		if(temp_vertex->has_local_message)
+		{
+			ip_combine(&temp_vertex->local_message, message);
+		}
+		else
+		{
+			temp_vertex->local_message = message;
+			temp_vertex->has_local_message = true;
+		}
+		if(!temp_vertex->locally_queued)
+		{
+			temp_vertex->locally_queued = true;
+			ip_push_local_vertex(location);
+		}
+	}
+	else
+	{
+		size_t slot = ip_get_mailbox_slot(ip_get_superstep() + 1);
+		if(ip_deliver_message(&temp_vertex->has_message[slot], &temp_vertex->message[slot], message))
+		{
+			ip_add_to_next_frontier(location);
+		}
+	}
+}
+
+void ip_add_to_next_frontier(size_t location)
+{
+	uint64_t mask = ((uint64_t)1) << (location % 64);
+	_Atomic uint64_t* word = &ip_all_frontiers[ip_get_mailbox_slot(ip_get_superstep() + 1)][location / 64];
+	// Most of the time the bit is already set by an earlier sender, there is no need to lock the cache line for it.
+	if((atomic_load_explicit(word, memory_order_relaxed) & mask) == 0 && (atomic_fetch_or_explicit(word, mask, memory_order_relaxed) & mask) == 0)
+	{
+		ip_all_thread_contexts[ip_my_thread_num].next_frontier_count++;
+	}
+}
+
+void ip_push_local_vertex(size_t location)
+{
+	struct ip_thread_context_t* my_context = &ip_all_thread_contexts[ip_my_thread_num];
+	if(my_context->local_worklist_last == my_context->local_worklist_max_size)
+	{
+		if(my_context->local_worklist_first > 0 && my_context->local_worklist_first >= my_context->local_worklist_last / 2)
+		{
+			// Reclaim the space of the vertices executed already rather than growing the buffer.
+			my_context->local_worklist_last -= my_context->local_worklist_first;
+			memmove(my_context->local_worklist, &my_context->local_worklist[my_context->local_worklist_first], sizeof(size_t) * my_context->local_worklist_last);
+			my_context->local_worklist_first = 0;
+		}
+		else
+		{
+			my_context->local_worklist_max_size = my_context->local_worklist_max_size == 0 ? 64 : my_context->local_worklist_max_size * 2;
+			my_context->local_worklist = ip_safe_realloc(my_context->local_worklist, sizeof(size_t) * my_context->local_worklist_max_size);
+		}
+	}
+	my_context->local_worklist[my_context->local_worklist_last] = location;
+	my_context->local_worklist_last++;
+}
+
+void ip_compute_vertex_at(size_t location)
+{
+	struct ip_vertex_t* temp_vertex = ip_get_vertex_by_location(location);
+	size_t slot = ip_get_mailbox_slot(ip_get_superstep());
+	// Nobody delivers into the slot read during the current superstep, the messages from the block can be merged into it.
+	if(temp_vertex->has_local_message)
+	{
+		if(atomic_load_explicit(&temp_vertex->has_message[slot], memory_order_relaxed) == IP_MAILBOX_FULL)
+		{
+			ip_combine(&temp_vertex->message[slot], temp_vertex->local_message);
+		}
+		else
+		{
+			temp_vertex->message[slot] = temp_vertex->local_message;
+			atomic_store_explicit(&temp_vertex->has_message[slot], IP_MAILBOX_FULL, memory_order_relaxed);
+		}
+		temp_vertex->has_local_message = false;
+	}
+	temp_vertex->active = true;
+	ip_compute(temp_vertex);
+	// Leave the slot read empty for the messages of next superstep.
+	if(ip_has_message(temp_vertex))
+	{
+		ip_empty_mailbox(&temp_vertex->has_message[slot], &temp_vertex->message[slot]);
+	}
+	if(temp_vertex->active)
+	{
+		ip_add_to_next_frontier(location);
+	}
+}
+
+void ip_compute_frontier_word(size_t word_index, uint64_t bits)
+{
+	struct ip_thread_context_t* my_context = &ip_all_thread_contexts[ip_my_thread_num];
+	while(bits != 0)
+	{
+		size_t location = word_index * 64 + __builtin_ctzll(bits);
+		bits &= bits - 1;
+		ip_compute_vertex_at(location);
+
+		// Propagate within the block before moving on.
+		while(my_context->local_worklist_first < my_context->local_worklist_last)
+		{
+			size_t local_location = my_context->local_worklist[my_context->local_worklist_first];
+			my_context->local_worklist_first++;
+			ip_get_vertex_by_location(local_location)->locally_queued = false;
+			ip_compute_vertex_at(local_location);
+		}
+		my_context->local_worklist_first = 0;
+		my_context->local_worklist_last = 0;
+	}
+}
+
+void ip_broadcast(struct ip_vertex_t* v, IP_MESSAGE_TYPE message)
+{
+	for(IP_NEIGHBOUR_COUNT_TYPE i = 0; i < v->out_neighbour_count; i++)
+	{
+		ip_send_message(v->out_neighbours[i], message);
+	}
+}
+
+void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
+{
+	for(IP_VERTEX_ID_TYPE i = first; i <= last; i++)
+	{
+		ip_all_vertices[i].id = i;
+		ip_all_vertices[i].active = true;
+		ip_all_vertices[i].has_local_message = false;
+		ip_all_vertices[i].locally_queued = false;
+		ip_empty_mailbox(&ip_all_vertices[i].has_message[0], &ip_all_vertices[i].message[0]);
+		ip_empty_mailbox(&ip_all_vertices[i].has_message[1], &ip_all_vertices[i].message[1]);
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+			ip_all_vertices[i].out_neighbour_count = 0;
+		#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_IDS
+			ip_all_vertices[i].out_neighbours = NULL;
+		#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_IDS
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+			ip_all_vertices[i].out_neighbour_weights = NULL;
+		#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+			ip_all_vertices[i].in_neighbours = NULL;
+		#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_COUNT
+			ip_all_vertices[i].in_neighbour_count = 0;
+		#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_COUNT
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+			ip_all_vertices[i].in_neighbour_weights = NULL;
+		#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHT
+	}
+}
+
+void ip_init_thread_context(struct ip_thread_context_t* context)
+{
+	context->next_frontier_count = 0;
+	// The blocks are those initialised by each thread, so a thread executes the vertices whose pages it placed.
+	ip_get_vertex_block(ip_my_thread_num, &context->block_first, &context->block_last);
+	context->local_worklist = NULL;
+	context->local_worklist_max_size = 0;
+	context->local_worklist_first = 0;
+	context->local_worklist_last = 0;
+}
+
+void ip_init_specific()
+{
+	ip_frontier_words_count = (ip_get_vertices_count() + 63) / 64;
+	ip_all_frontiers[0] = (_Atomic uint64_t*)ip_safe_malloc(sizeof(_Atomic uint64_t) * ip_frontier_words_count);
+	ip_all_frontiers[1] = (_Atomic uint64_t*)ip_safe_malloc(sizeof(_Atomic uint64_t) * ip_frontier_words_count);
+	// All vertices are executed at superstep 0.
+	for(size_t i = 0; i < ip_frontier_words_count; i++)
+	{
+		atomic_init(&ip_all_frontiers[0][i], UINT64_MAX);
+		atomic_init(&ip_all_frontiers[1][i], 0);
+	}
+	if(ip_get_vertices_count() % 64 != 0)
+	{
+		atomic_init(&ip_all_frontiers[0][ip_frontier_words_count - 1], (((uint64_t)1) << (ip_get_vertices_count() % 64)) - 1);
+	}
+}
+
+int ip_run()
+{
+	double timer_superstep_total = 0;
+	double timer_superstep_start = 0;
+	double timer_superstep_stop = 0;
+
+	#pragma omp parallel default(none) shared(ip_active_vertices, \
+											  ip_all_frontiers, \
+											  ip_all_thread_contexts, \
+											  ip_thread_count, \
+											  timer_superstep_total, \
+											  timer_superstep_start, \
+											  timer_superstep_stop)
+	{
+		ip_my_thread_num = omp_get_thread_num();
+		struct ip_thread_context_t* my_context = &ip_all_thread_contexts[ip_my_thread_num];
+		while(ip_active_vertices != 0)
+		{
+			// This barrier is crucial; otherwise a thread may enter the single, change ip_active_vertices before one other thread has entered the loop. Thus the single would never complete.
+			#pragma omp barrier
+
+			//////////////////
+			// START TIMER //
+			////////////////
+			// This OpenMP single also acts as an implicit barrier to wait for all threads before they start processing a superstep.
+			#pragma omp single
+			{
+				timer_superstep_start = omp_get_wtime();
+				ip_active_vertices = 0;
+			}
+
+			_Atomic uint64_t* frontier = ip_all_frontiers[ip_get_mailbox_slot(ip_get_superstep())];
+			for(size_t i = my_context->block_first / 64; my_context->block_first < my_context->block_last && i <= (my_context->block_last - 1) / 64; i++)
+			{
+				// Blocks are not aligned on words, so only the bits of this block are taken from the word.
+				uint64_t mask = UINT64_MAX;
+				if(i == my_context->block_first / 64)
+				{
+					mask &= UINT64_MAX << (my_context->block_first % 64);
+				}
+				if(i == (my_context->block_last - 1) / 64 && my_context->block_last % 64 != 0)
+				{
+					mask &= UINT64_MAX >> (64 - my_context->block_last % 64);
+				}
+				uint64_t bits = atomic_load_explicit(&frontier[i], memory_order_relaxed) & mask;
+				if(bits != 0)
+				{
+					atomic_fetch_and_explicit(&frontier[i], ~bits, memory_order_relaxed);
+					ip_compute_frontier_word(i, bits);
+				}
+			}
+
+			// All threads must be done adding vertices to the frontier of next superstep.
+			#pragma omp barrier
+			#ifdef IP_NEEDS_REMOTE_VALUES
+				ip_commit_values();
+			#endif // ifdef IP_NEEDS_REMOTE_VALUES
+			#pragma omp single
+			{
+				// Every vertex in the frontier of next superstep was added by exactly one thread.
+				for(int i = 0; i < ip_thread_count; i++)
+				{
+					ip_active_vertices += ip_all_thread_contexts[i].next_frontier_count;
+					ip_all_thread_contexts[i].next_frontier_count = 0;
+				}
+				timer_superstep_stop = omp_get_wtime();
+				timer_superstep_total += timer_superstep_stop - timer_superstep_start;
+				printf("Superstep%zuDuration:%f\n", ip_get_superstep(), timer_superstep_stop - timer_superstep_start);
+				printf("Superstep%zuActiveVertexCount:%zu\n", ip_get_superstep(), ip_active_vertices);
+				ip_reduce_aggregators();
+				ip_increment_superstep();
+ 			} // End of OpenMP single region
+		} // End of superstep processing loop
+ 	} // End of OpenMP region
+
+	printf("Total time of supersteps: %fs.\n", timer_superstep_total);
+
+	return 0;
+}
+
+void ip_vote_to_halt(struct ip_vertex_t* v)
+{
+	v->active = false;
+}
+
+#endif // COMBINER_BLOCK_CENTRIC_POSTAMBLE_H_INCLUDED
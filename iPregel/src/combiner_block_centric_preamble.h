@@ -0,0 +1,162 @@
+/**
+ * @file combiner_block_centric_preamble.h
+ * @copyright Copyright (C) 2019 Ludovic Capelli
+ * @par License
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ * @author Ludovic Capelli
+ * @brief This version lets every thread run its own block of vertices to a
+ * local fixpoint within each superstep.
+ * @details The vertices are split into as many contiguous blocks as there are
+ * threads, as they are during the initialisation, and each thread executes the
+ * vertices of its own block only. When a vertex sends a message to a vertex of
+ * the same block, the message is combined into a local mailbox that no other
+ * thread touches and the recipient is queued on the local worklist of the
+ * thread, which executes it within the same superstep. Only the messages that
+ * cross blocks go through the lock-free mailboxes and wait for next superstep.
+ * On graphs whose vertex numbering is local, such as reordered graphs, a hop
+ * inside a block no longer costs a superstep, and connected components or
+ * single-source shortest paths need far fewer supersteps.
+ * - a vertex may be executed several times in a superstep, each time with the
+ * messages combined since its previous execution. This version is therefore
+ * meant for the algorithms that converge to a fixpoint, such as those using a
+ * minimum combiner.
+ * - messages sent at superstep 0 all wait for superstep 1 so that the vertices
+ * are only executed once in the first superstep.
+ * - blocks are static, the schedule passed to ip_init() is ignored.
+ **/
+
+#ifndef COMBINER_BLOCK_CENTRIC_PREAMBLE_H_INCLUDED
+#define COMBINER_BLOCK_CENTRIC_PREAMBLE_H_INCLUDED
+
+#if defined(IP_COMBINER_SUM) || defined(IP_COMBINER_FLOATING_SUM)
+	#error The block-centric version requires a monotone combiner such as a minimum or a maximum, a sum never reaches a local fixpoint.
+#endif // if defined(IP_COMBINER_SUM) || defined(IP_COMBINER_FLOATING_SUM)
+
+#ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
+	#define IP_NEEDS_OUT_NEIGHBOUR_IDS
+#endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
+
+#ifndef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+	#define IP_NEEDS_OUT_NEIGHBOUR_COUNT
+#endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+
+#include <stdatomic.h>
+
+// Global variables
+/// This structure defines the structure of a vertex.
+struct ip_vertex_t
+{
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_IDS
+		/// Contains the identifiers of the out-neighbours
+		IP_VERTEX_ID_TYPE* out_neighbours;
+	#endif // IP_NEEDS_OUT_NEIGHBOUR_IDS
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+		/// Contains the identifiers of the in-neighbours
+		IP_VERTEX_ID_TYPE* in_neighbours;
+	#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+		/// Contains the number of out-neighbours
+		IP_NEIGHBOUR_COUNT_TYPE out_neighbour_count;
+	#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_COUNT
+		/// Contains the number of in-neighbours
+		IP_NEIGHBOUR_COUNT_TYPE in_neighbour_count;
+	#endif // IP_NEEDS_IN_NEIGHBOUR_COUNT
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+		/// Contains the weights of out-edges
+		IP_EDGE_WEIGHT_TYPE* out_neighbour_weights;
+	#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+		/// Contains the weights of the in-neighbours
+		IP_EDGE_WEIGHT_TYPE* in_neighbour_weights;
+	#endif // IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+	/// Contains the vertex status
+	bool active;
+	/// Indicates whether the vertex received messages from its own block since its last execution
+	bool has_local_message;
+	/// Indicates whether the vertex is in the local worklist of the thread owning its block
+	bool locally_queued;
+	/// Indicates whether the vertex has received messages from other blocks, the slot of the previous superstep is read while the other is written; see ip_get_mailbox_slot()
+	IP_MAILBOX_FLAG_TYPE has_message[2];
+	/// Contains the vertex identifier
+	IP_VERTEX_ID_TYPE id;
+	/// Contains the combined messages received from other blocks, indexed like has_message
+	IP_MESSAGE_TYPE message[2];
+	/// Contains the combined messages received from its own block
+	IP_MESSAGE_TYPE local_message;
+	/// Contains the user-defined value
+	IP_VALUE_TYPE value;
+};
+/// This structure holds the data that a thread uses during a superstep.
+struct ip_thread_context_t
+{
+	/// The number of vertices that the thread added to the frontier of next superstep.
+	_Alignas(IP_CACHE_LINE_SIZE) size_t next_frontier_count;
+	/// The location of the first vertex of the block of the thread.
+	size_t block_first;
+	/// The location following that of the last vertex of the block of the thread.
+	size_t block_last;
+	/// The locations of the vertices of the block that received a message from the block and wait to be executed.
+	size_t* local_worklist;
+	/// The size of the memory buffer. It is used for reallocation purpose.
+	size_t local_worklist_max_size;
+	/// The position of the oldest vertex in the local worklist, which is executed first.
+	size_t local_worklist_first;
+	/// The position following that of the newest vertex in the local worklist.
+	size_t local_worklist_last;
+};
+/// The number of 64-bit words in a frontier bitmap.
+size_t ip_frontier_words_count = 0;
+/// The vertices to execute, one bitmap per superstep parity: the bitmap of the current superstep is read while the other one is filled for next superstep.
+_Atomic uint64_t* ip_all_frontiers[2] = {NULL, NULL};
+
+/**
+ * @brief This function returns the mailbox slot that is read at the superstep
+ * \p superstep.
+ * @details Mailboxes receiving the messages from other blocks are
+ * double-buffered by superstep parity, like those of the version with
+ * combiner.
+ * @param[in] superstep The superstep number.
+ * @return The slot to read, the other one being written.
+ **/
+size_t ip_get_mailbox_slot(size_t superstep);
+/**
+ * @brief This function adds the vertex at location \p location to the
+ * frontier of next superstep.
+ * @param[in] location The location of the vertex.
+ * @post The next_frontier_count of the calling thread is incremented if the
+ * vertex was not already in that frontier.
+ **/
+void ip_add_to_next_frontier(size_t location);
+/**
+ * @brief This function queues the vertex at location \p location, which
+ * belongs to the block of the calling thread, on the local worklist.
+ * @param[in] location The location of the vertex.
+ **/
+void ip_push_local_vertex(size_t location);
+/**
+ * @brief This function executes the vertex at location \p location with the
+ * messages it received from other blocks at previous superstep and from its
+ * own block since its last execution.
+ * @param[in] location The location of the vertex.
+ * @pre The vertex belongs to the block of the calling thread.
+ **/
+void ip_compute_vertex_at(size_t location);
+/**
+ * @brief This function executes the vertices whose bit is set in \p bits,
+ * each followed by the vertices of the local worklist until it is empty.
+ * @param[in] word_index The index of the frontier word \p bits comes from.
+ * @param[in] bits The bits of the vertices to execute.
+ **/
+void ip_compute_frontier_word(size_t word_index, uint64_t bits);
+
+#endif // COMBINER_BLOCK_CENTRIC_PREAMBLE_H_INCLUDED
@@ -0,0 +1,531 @@
+/**
+ * @file combiner_hybrid_postamble.h
+ * @copyright Copyright (C) 2019 Ludovic Capelli
+ * @par License
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ * @author Ludovic Capelli
+ **/
+
+#ifndef COMBINER_HYBRID_POSTAMBLE_H_INCLUDED
+#define COMBINER_HYBRID_POSTAMBLE_H_INCLUDED
+
+#include <omp.h>
+#include <string.h>
+
+bool ip_has_message(struct ip_vertex_t* v)
+{
+	return v->has_message;
+}
+
+bool ip_get_next_message(struct ip_vertex_t* v, IP_MESSAGE_TYPE* message_value)
+{
+	if(v->has_message)
+	{
+		*message_value = v->message;
+		v->has_message = false;
+		return true;
+	}
+
+	return false;
+}
+
+void ip_add_spread_vertex(IP_VERTEX_ID_TYPE id)
+{
+	struct ip_vertex_list_t* my_list = &ip_all_thread_contexts[ip_my_thread_num].spread_vertices;
+	if(my_list->size == my_list->max_size)
+	{
+		my_list->max_size *= 2;
+		my_list->data = ip_safe_realloc(my_list->data, sizeof(IP_VERTEX_ID_TYPE) * my_list->max_size);
+	}
+
+	my_list->data[my_list->size] = id;
+	my_list->size++;
+}
+
+void ip_send_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
+{
+	#ifdef IP_USE_PROPAGATION_BLOCKING
+		ip_bin_message(id, message);
+	#else
+		#ifdef IP_USE_HUB_MAILBOXES
+			if(ip_has_hub_mailboxes(id))
+			{
+				ip_deliver_to_hub_mailbox(id, message);
+				return;
+			}
+		#endif // ifdef IP_USE_HUB_MAILBOXES
+		if(ip_deliver_message(&ip_all_externalised_structures[id].has_message_next, &ip_all_externalised_structures[id].message_next, message))
+		{
+			ip_add_spread_vertex(id);
+		}
+	#endif // ifdef IP_USE_PROPAGATION_BLOCKING
+}
+
+#if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES)
+	void ip_deliver_binned_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
+	{
+		if(ip_deliver_message_exclusively(&ip_all_externalised_structures[id].has_message_next, &ip_all_externalised_structures[id].message_next, message))
+		{
+			ip_add_spread_vertex(id);
+		}
+	}
+#endif // if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES)
+
+void ip_broadcast(struct ip_vertex_t* v, IP_MESSAGE_TYPE message)
+{
+	if(ip_direction == IP_DIRECTION_PULL)
+	{
+		ip_all_broadcast_structures[v->id].has_broadcast_message = true;
+		ip_all_broadcast_structures[v->id].broadcast_message = message;
+	}
+	else
+	{
+		#ifdef IP_USE_HUB_BROADCASTS
+			if(ip_defer_hub_broadcast(v, message))
+			{
+				return;
+			}
+		#endif // ifdef IP_USE_HUB_BROADCASTS
+		for(IP_NEIGHBOUR_COUNT_TYPE i = 0; i < v->out_neighbour_count; i++)
+		{
+			ip_send_message(v->out_neighbours[i], message);
+		}
+	}
+}
+
+void ip_fetch_broadcast_messages(struct ip_vertex_t* v)
+{
+	// Start from the messages pushed with ip_send_message, if any; the sender already flagged v for next superstep.
+	v->has_message = ip_all_externalised_structures[v->id].has_message_next == IP_MAILBOX_FULL;
+	if(v->has_message)
+	{
+		v->message = ip_all_externalised_structures[v->id].message_next;
+		ip_empty_mailbox(&ip_all_externalised_structures[v->id].has_message_next, &ip_all_externalised_structures[v->id].message_next);
+	}
+
+	for(IP_NEIGHBOUR_COUNT_TYPE i = 0; i < v->in_neighbour_count; i++)
+	{
+		if(ip_all_broadcast_structures[v->in_neighbours[i]].has_broadcast_message)
+		{
+			if(v->has_message)
+			{
+				ip_combine(&v->message, ip_all_broadcast_structures[v->in_neighbours[i]].broadcast_message);
+			}
+			else
+			{
+				v->has_message = true;
+				v->message = ip_all_broadcast_structures[v->in_neighbours[i]].broadcast_message;
+				ip_add_spread_vertex(v->id);
+			}
+		}
+	}
+}
+
+void ip_select_direction(size_t vertices_count, size_t edges_count)
+{
+	if(ip_direction == IP_DIRECTION_PUSH)
+	{
+		if(edges_count > ip_get_edges_count() / IP_HYBRID_ALPHA)
+		{
+			ip_direction = IP_DIRECTION_PULL;
+		}
+	}
+	else
+	{
+		if(vertices_count < ip_get_vertices_count() / IP_HYBRID_BETA)
+		{
+			ip_direction = IP_DIRECTION_PUSH;
+		}
+	}
+}
+
+void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
+{
+	for(IP_VERTEX_ID_TYPE i = first; i <= last; i++)
+	{
+		ip_all_vertices[i].id = i;
+		ip_all_vertices[i].has_message = false;
+		ip_empty_mailbox(&ip_all_externalised_structures[i].has_message_next, &ip_all_externalised_structures[i].message_next);
+		ip_all_broadcast_structures[i].has_broadcast_message = false;
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+			ip_all_vertices[i].out_neighbour_count = 0;
+		#endif // IP_NEEDS_OUT_NEIGHBOUR_COUNT
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_IDS
+			ip_all_vertices[i].out_neighbours = NULL;
+		#endif // IP_NEEDS_OUT_NEIGHBOUR_IDS
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+			ip_all_vertices[i].out_neighbour_weights = NULL;
+		#endif // IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+			ip_all_vertices[i].in_neighbours = NULL;
+		#endif
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_COUNT
+			ip_all_vertices[i].in_neighbour_count = 0;
+		#endif // IP_NEEDS_IN_NEIGHBOUR_COUNT
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+			ip_all_vertices[i].in_neighbour_weights = NULL;
+		#endif // IP_NEEDS_IN_NEIGHBOUR_WEIGHT
+	}
+}
+
+void ip_init_thread_context(struct ip_thread_context_t* context)
+{
+	context->spread_vertices.max_size = 1;
+	context->spread_vertices.size = 0;
+	context->spread_vertices.data = ip_safe_malloc(sizeof(IP_VERTEX_ID_TYPE) * context->spread_vertices.max_size);
+}
+
+void ip_init_specific()
+{
+	ip_all_spread_vertices.max_size = 1;
+	ip_all_spread_vertices.size = 0;
+	ip_all_spread_vertices.data = ip_safe_malloc(sizeof(IP_VERTEX_ID_TYPE) * ip_all_spread_vertices.max_size);
+	ip_all_externalised_structures = (struct ip_externalised_structure_t*)ip_safe_malloc(sizeof(struct ip_externalised_structure_t) * ip_get_vertices_count());
+	ip_all_broadcast_structures = (struct ip_broadcast_structure_t*)ip_safe_malloc(sizeof(struct ip_broadcast_structure_t) * ip_get_vertices_count());
+}
+
+int ip_run()
+{
+	double timer_superstep_total = 0;
+	double timer_superstep_start = 0;
+	double timer_superstep_stop = 0;
+
+	printf("HybridThresholds:alpha=%d,beta=%d\n", IP_HYBRID_ALPHA, IP_HYBRID_BETA);
+
+	#pragma omp parallel default(none) shared(ip_all_thread_contexts, \
+											  ip_active_vertices, \
+											  ip_use_edge_stealing, \
+											  ip_direction, \
+											  ip_spread_edges_count, \
+											  ip_all_spread_vertices, \
+											  ip_thread_count, \
+											  ip_all_externalised_structures, \
+											  ip_all_broadcast_structures, \
+											  timer_superstep_total, \
+											  timer_superstep_start, \
+											  timer_superstep_stop)
+	{
+		ip_my_thread_num = omp_get_thread_num();
+		while(ip_is_first_superstep() || ip_active_vertices > 0)
+		{
+			// This barrier is crucial; otherwise a thread may enter the single, change ip_active_vertices before one other thread has entered the loop. Thus the single would never complete.
+			#pragma omp barrier
+
+			//////////////////
+			// START TIMER //
+			////////////////
+			// This OpenMP single also acts as an implicit barrier to wait for all threads before they start processing a superstep.
+			#pragma omp single
+			{
+				if(ip_is_first_superstep())
+				{
+					ip_select_direction(ip_get_vertices_count(), ip_get_edges_count());
+				}
+				else
+				{
+					ip_select_direction(ip_all_spread_vertices.size, ip_spread_edges_count);
+				}
+				ip_active_vertices = 0;
+				ip_spread_edges_count = 0;
+				timer_superstep_start = omp_get_wtime();
+			}
+
+			////////////////////
+			// COMPUTE PHASE //
+			//////////////////
+			#ifdef IP_ENABLE_THREAD_PROFILING
+				ip_all_thread_contexts[ip_my_thread_num].timer_compute_start = omp_get_wtime();
+				ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop = ip_all_thread_contexts[ip_my_thread_num].timer_compute_start;
+			#endif
+			struct ip_vertex_t* temp_vertex = NULL;
+			if(ip_use_edge_stealing)
+			{
+				bool all_vertices = ip_is_first_superstep();
+				size_t chunk_first;
+				size_t chunk_last;
+				ip_prepare_chunks(all_vertices ? NULL : ip_all_spread_vertices.data, all_vertices ? ip_get_vertices_count() : ip_all_spread_vertices.size);
+				while(ip_get_next_chunk(&chunk_first, &chunk_last))
+				{
+					for(size_t i = chunk_first; i < chunk_last; i++)
+					{
+						temp_vertex = all_vertices ? ip_get_vertex_by_location(i) : ip_get_vertex_by_id(ip_all_spread_vertices.data[i]);
+						ip_compute(temp_vertex);
+						#ifdef IP_ENABLE_THREAD_PROFILING
+							ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop = omp_get_wtime();
+						#endif
+					}
+				}
+				// Replaces the implicit barrier of the OpenMP for below.
+				#pragma omp barrier
+			}
+			else if(ip_is_first_superstep())
+			{
+				#pragma omp for schedule(runtime)
+				for(size_t i = 0; i < ip_get_vertices_count(); i++)
+				{
+					temp_vertex = ip_get_vertex_by_location(i);
+					ip_compute(temp_vertex);
+					#ifdef IP_ENABLE_THREAD_PROFILING
+						ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop = omp_get_wtime();
+					#endif
+				}
+			}
+			else
+			{
+				#pragma omp for schedule(runtime)
+				for(size_t i = 0; i < ip_all_spread_vertices.size; i++)
+				{
+					temp_vertex = ip_get_vertex_by_id(ip_all_spread_vertices.data[i]);
+					ip_compute(temp_vertex);
+					#ifdef IP_ENABLE_THREAD_PROFILING
+						ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop = omp_get_wtime();
+					#endif
+				}
+			}
+			#ifdef IP_ENABLE_THREAD_PROFILING
+				ip_all_thread_contexts[ip_my_thread_num].timer_compute_total = ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop - ip_all_thread_contexts[ip_my_thread_num].timer_compute_start;
+			#endif
+
+			#ifdef IP_USE_HUB_BROADCASTS
+				//////////////////////////
+				// HUB BROADCAST PHASE //
+				////////////////////////
+				ip_run_hub_broadcasts();
+			#endif // ifdef IP_USE_HUB_BROADCASTS
+
+			#ifdef IP_USE_HUB_MAILBOXES
+				////////////////////////
+				// HUB MAILBOX PHASE //
+				//////////////////////
+				// Every hub gets the combination of the partial mailboxes that threads filled for it.
+				ip_combine_hub_mailboxes();
+			#endif // ifdef IP_USE_HUB_MAILBOXES
+
+			#ifdef IP_USE_PROPAGATION_BLOCKING
+				/////////////////////////
+				// BIN DELIVERY PHASE //
+				///////////////////////
+				// Deliver the messages binned during the compute phase; the first delivery into a mailbox flags the vertex for next superstep.
+				ip_apply_bins();
+			#endif // ifdef IP_USE_PROPAGATION_BLOCKING
+
+			/////////////////////////////
+			// MESSAGE FETCHING PHASE //
+			///////////////////////////
+			// When pulling, every vertex gathers the broadcasts of its in-neighbours, then the broadcasts are cleared. Both loops must be separated by a barrier since a broadcast can be read by any out-neighbour.
+			#ifdef IP_ENABLE_THREAD_PROFILING
+				ip_all_thread_contexts[ip_my_thread_num].timer_fetching_start = omp_get_wtime();
+				ip_all_thread_contexts[ip_my_thread_num].timer_fetching_stop = ip_all_thread_contexts[ip_my_thread_num].timer_fetching_start;
+			#endif
+			if(ip_direction == IP_DIRECTION_PULL)
+			{
+				#pragma omp for reduction(+:ip_spread_edges_count) schedule(runtime)
+				for(size_t i = 0; i < ip_get_vertices_count(); i++)
+				{
+					temp_vertex = ip_get_vertex_by_location(i);
+					ip_fetch_broadcast_messages(temp_vertex);
+					if(temp_vertex->has_message)
+					{
+						ip_spread_edges_count += temp_vertex->out_neighbour_count;
+					}
+					#ifdef IP_ENABLE_THREAD_PROFILING
+						ip_all_thread_contexts[ip_my_thread_num].timer_fetching_stop = omp_get_wtime();
+					#endif
+				}
+
+				if(ip_is_first_superstep())
+				{
+					#pragma omp for schedule(runtime)
+					for(size_t i = 0; i < ip_get_vertices_count(); i++)
+					{
+						ip_all_broadcast_structures[i].has_broadcast_message = false;
+					}
+				}
+				else
+				{
+					#pragma omp for schedule(runtime)
+					for(size_t i = 0; i < ip_all_spread_vertices.size; i++)
+					{
+						ip_all_broadcast_structures[ip_all_spread_vertices.data[i]].has_broadcast_message = false;
+					}
+				}
+				#ifdef IP_ENABLE_THREAD_PROFILING
+					ip_all_thread_contexts[ip_my_thread_num].timer_fetching_stop = omp_get_wtime();
+				#endif
+			}
+			#ifdef IP_ENABLE_THREAD_PROFILING
+				ip_all_thread_contexts[ip_my_thread_num].timer_fetching_total = ip_all_thread_contexts[ip_my_thread_num].timer_fetching_stop - ip_all_thread_contexts[ip_my_thread_num].timer_fetching_start;
+			#endif
+
+			//////////////////////////////////
+			// SPREAD VERTICES MERGE PHASE //
+			////////////////////////////////
+			#ifdef IP_ENABLE_THREAD_PROFILING
+				ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_start = omp_get_wtime();
+				ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_stop = ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_start;
+			#endif
+			// Every thread copies its own list right after those of the threads before it.
+			struct ip_vertex_list_t* my_list = &ip_all_thread_contexts[ip_my_thread_num].spread_vertices;
+			size_t my_offset = 0;
+			for(int i = 0; i < ip_my_thread_num; i++)
+			{
+				my_offset += ip_all_thread_contexts[i].spread_vertices.size;
+			}
+			#pragma omp single
+			{
+				// The barrier ending the phase above guarantees that all threads are done filling their lists.
+				for(int i = 0; i < ip_thread_count; i++)
+				{
+					ip_active_vertices += ip_all_thread_contexts[i].spread_vertices.size;
+				}
+				if(ip_all_spread_vertices.max_size < ip_active_vertices)
+				{
+					ip_all_spread_vertices.data = ip_safe_realloc(ip_all_spread_vertices.data, sizeof(IP_VERTEX_ID_TYPE) * ip_active_vertices);
+					ip_all_spread_vertices.max_size = ip_active_vertices;
+				}
+				ip_all_spread_vertices.size = ip_active_vertices;
+			}
+			if(my_list->size > 0)
+			{
+				memcpy(&ip_all_spread_vertices.data[my_offset], my_list->data, my_list->size * sizeof(IP_VERTEX_ID_TYPE));
+				my_list->size = 0;
+			}
+			#ifdef IP_ENABLE_THREAD_PROFILING
+				ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_stop = omp_get_wtime();
+			#endif
+			// The vertices to execute are read by all threads from now on.
+			#pragma omp barrier
+			#ifdef IP_ENABLE_THREAD_PROFILING
+				ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_total = ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_stop - ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_start;
+			#endif
+
+			///////////////////////////
+			// MAILBOX UPDATE PHASE //
+			/////////////////////////
+			// When pushing, take in account only the vertices that have been
+			// flagged as spread -> that is, vertices having received a new
+			// message. When pulling, the fetching phase already did it.
+			#ifdef IP_ENABLE_THREAD_PROFILING
+				ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_start = omp_get_wtime();
+				ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_stop = ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_start;
+			#endif
+			if(ip_direction == IP_DIRECTION_PUSH)
+			{
+				IP_VERTEX_ID_TYPE spread_vertex_id;
+				#pragma omp for reduction(+:ip_spread_edges_count) schedule(runtime)
+				for(size_t i = 0; i < ip_all_spread_vertices.size; i++)
+				{
+					spread_vertex_id = ip_all_spread_vertices.data[i];
+					temp_vertex = ip_get_vertex_by_id(spread_vertex_id);
+					temp_vertex->has_message = true;
+					temp_vertex->message = ip_all_externalised_structures[spread_vertex_id].message_next;
+					ip_empty_mailbox(&ip_all_externalised_structures[spread_vertex_id].has_message_next, &ip_all_externalised_structures[spread_vertex_id].message_next);
+					ip_spread_edges_count += temp_vertex->out_neighbour_count;
+					#ifdef IP_ENABLE_THREAD_PROFILING
+						ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_stop = omp_get_wtime();
+					#endif
+				}
+			}
+			#ifdef IP_ENABLE_THREAD_PROFILING
+				ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_total = ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_stop - ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_start;
+			#endif
+
+			#ifdef IP_NEEDS_REMOTE_VALUES
+				ip_commit_values();
+			#endif // ifdef IP_NEEDS_REMOTE_VALUES
+			#pragma omp single
+			{
+				timer_superstep_stop = omp_get_wtime();
+				timer_superstep_total += (timer_superstep_stop - timer_superstep_start);
+				printf("Superstep%zuDuration:%f\n", ip_get_superstep(), timer_superstep_stop - timer_superstep_start);
+				printf("Superstep%zuDirection:%s\n", ip_get_superstep(), ip_direction == IP_DIRECTION_PUSH ? "push" : "pull");
+				printf("Superstep%zuActiveVertexCount:%zu\n", ip_get_superstep(), ip_active_vertices);
+				#ifdef IP_ENABLE_THREAD_PROFILING
+					printf("            +");
+					for(int i = 0; i < ip_thread_count; i++)
+					{
+						printf("-----------+");
+					}
+					printf("\n            |");
+					for(int i = 0; i < ip_thread_count; i++)
+					{
+						printf(" Thread %2d |", i);
+					}
+					printf("\n+-----------+");
+					for(int i = 0; i < ip_thread_count; i++)
+					{
+						printf("-----------+");
+					}
+					printf("\n|   Compute |");
+					for(int i = 0; i < ip_thread_count; i++)
+					{
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_compute_total);
+					}
+					printf("\n|  Fetching |");
+					for(int i = 0; i < ip_thread_count; i++)
+					{
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_fetching_total);
+					}
+					printf("\n|   Merging |");
+					for(int i = 0; i < ip_thread_count; i++)
+					{
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_spread_merge_total);
+					}
+					printf("\n|   Mailbox |");
+					for(int i = 0; i < ip_thread_count; i++)
+					{
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_mailbox_update_total);
+					}
+					printf("\n|     Total |");
+					for(int i = 0; i < ip_thread_count; i++)
+					{
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_compute_total + ip_all_thread_contexts[i].timer_fetching_total + ip_all_thread_contexts[i].timer_spread_merge_total + ip_all_thread_contexts[i].timer_mailbox_update_total);
+					}
+					printf("\n+-----------+");
+					for(int i = 0; i < ip_thread_count; i++)
+					{
+						printf("-----------+");
+					}
+					printf("\n");
+				#endif
+				ip_reduce_aggregators();
+				ip_increment_superstep();
+ 			} // End of OpenMP single region
+		} // End of superstep processing loop
+ 	} // End of OpenMP region
+
+	printf("Total time of supersteps: %fs.\n", timer_superstep_total);
+
+	// Free and clean program.
+	#pragma omp parallel
+	{
+		ip_safe_free(ip_all_thread_contexts[omp_get_thread_num()].spread_vertices.data);
+	}
+	ip_safe_free(ip_all_spread_vertices.data);
+
+	free(ip_all_externalised_structures);
+	free(ip_all_broadcast_structures);
+	#ifdef IP_USE_HUB_BROADCASTS
+		ip_free_hub_broadcasts();
+	#endif // ifdef IP_USE_HUB_BROADCASTS
+	#ifdef IP_USE_HUB_MAILBOXES
+		ip_free_hub_mailboxes();
+	#endif // ifdef IP_USE_HUB_MAILBOXES
+
+	return 0;
+}
+
+void ip_vote_to_halt(struct ip_vertex_t* v)
+{
+	(void)(v);
+}
+#endif // COMBINER_HYBRID_POSTAMBLE_H_INCLUDED
@@ -0,0 +1,203 @@
+/**
+ * @file combiner_hybrid_preamble.h
+ * @copyright Copyright (C) 2019 Ludovic Capelli
+ * @par License
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ * @author Ludovic Capelli
+ * @brief This version switches between push and pull at every superstep.
+ * @details This version keeps both the out- and in-adjacency of every vertex.
+ * At the beginning of every superstep, it looks at the number of vertices to
+ * execute and at the number of out-edges they have, and picks a direction:
+ * - push: broadcasts are delivered into the mailboxes of the out-neighbours,
+ * as in the spread version. It is the best choice when few vertices run.
+ * - pull: broadcasts are stored in the broadcasting vertex, and every vertex
+ * then fetches the messages of its in-neighbours, as in the single broadcast
+ * version. It is the best choice when a large part of the graph runs.
+ * Like the spread version, only the vertices that received a message are
+ * executed at the next superstep.
+ **/
+
+#ifndef COMBINER_HYBRID_PREAMBLE_H_INCLUDED
+#define COMBINER_HYBRID_PREAMBLE_H_INCLUDED
+
+#include <stdatomic.h>
+
+#ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
+	#define IP_NEEDS_OUT_NEIGHBOUR_IDS
+#endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
+
+#ifndef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+	#define IP_NEEDS_OUT_NEIGHBOUR_COUNT
+#endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+
+#ifndef IP_NEEDS_IN_NEIGHBOUR_IDS
+	#define IP_NEEDS_IN_NEIGHBOUR_IDS
+#endif // ifndef IP_NEEDS_IN_NEIGHBOUR_IDS
+
+#ifndef IP_NEEDS_IN_NEIGHBOUR_COUNT
+	#define IP_NEEDS_IN_NEIGHBOUR_COUNT
+#endif // ifndef IP_NEEDS_IN_NEIGHBOUR_COUNT
+
+#ifndef IP_HYBRID_ALPHA
+	/// The engine switches from push to pull when the out-edges of the vertices to execute exceed 1 / IP_HYBRID_ALPHA of all edges.
+	#define IP_HYBRID_ALPHA 14
+#endif // ifndef IP_HYBRID_ALPHA
+
+#ifndef IP_HYBRID_BETA
+	/// The engine switches from pull back to push when the vertices to execute drop below 1 / IP_HYBRID_BETA of all vertices.
+	#define IP_HYBRID_BETA 24
+#endif // ifndef IP_HYBRID_BETA
+
+// Global variables
+/// The directions in which messages can travel during a superstep.
+enum ip_direction_t
+{
+	/// Senders write into the mailboxes of their out-neighbours.
+	IP_DIRECTION_PUSH,
+	/// Receivers read the broadcasts of their in-neighbours.
+	IP_DIRECTION_PULL
+};
+/// The direction used by the current superstep.
+enum ip_direction_t ip_direction = IP_DIRECTION_PULL;
+/// This structure holds a list of vertex identifiers.
+struct ip_vertex_list_t
+{
+	/// The size of the memory buffer. It is used for reallocation purpose.
+	size_t max_size;
+	/// The number of identifiers currently stored.
+	size_t size;
+	/// The actual identifiers.
+	IP_VERTEX_ID_TYPE* data;
+};
+/// This contains all the vertices to execute next superstep.
+struct ip_vertex_list_t ip_all_spread_vertices;
+/// This structure holds the state private to each thread; each instance sits on its own cache lines to avoid false sharing.
+struct ip_thread_context_t
+{
+	/// The vertices this thread found to be executed next superstep.
+	_Alignas(IP_CACHE_LINE_SIZE) struct ip_vertex_list_t spread_vertices;
+	#ifdef IP_ENABLE_THREAD_PROFILING
+		/// The time at which this thread started the compute phase at current superstep.
+		double timer_compute_start;
+		/// The time at which this thread stopped the compute phase at current superstep.
+		double timer_compute_stop;
+		/// The time spent by this thread in the compute phase, accumulated over all supersteps.
+		double timer_compute_total;
+		/// The time at which this thread started fetching messages at current superstep.
+		double timer_fetching_start;
+		/// The time at which this thread stopped fetching messages at current superstep.
+		double timer_fetching_stop;
+		/// The time spent by this thread in fetching messages, accumulated over all supersteps.
+		double timer_fetching_total;
+		/// The time at which this thread started the mailbox update phase at current superstep.
+		double timer_mailbox_update_start;
+		/// The time at which this thread stopped the mailbox update phase at current superstep.
+		double timer_mailbox_update_stop;
+		/// The time spent by this thread in the mailbox update phase, accumulated over all supersteps.
+		double timer_mailbox_update_total;
+		/// The time at which this thread started merging the spread vertices at current superstep.
+		double timer_spread_merge_start;
+		/// The time at which this thread stopped merging the spread vertices at current superstep.
+		double timer_spread_merge_stop;
+		/// The time spent by this thread in merging the spread vertices, accumulated over all supersteps.
+		double timer_spread_merge_total;
+	#endif // ifdef IP_ENABLE_THREAD_PROFILING
+};
+/// The total number of out-edges of the vertices to execute next superstep.
+size_t ip_spread_edges_count = 0;
+/// Contains the mailbox attributes used when pushing
+struct ip_externalised_structure_t
+{
+	/// Indicates whether the vertex has received messages from current superstep so far
+	IP_MAILBOX_FLAG_TYPE has_message_next;
+	/// Contains the combined message made from message received from current superstep so far
+	IP_MESSAGE_TYPE message_next;
+};
+/// Contains the mailbox attributes for all vertices
+struct ip_externalised_structure_t* ip_all_externalised_structures = NULL;
+/// Contains the broadcast attributes used when pulling
+struct ip_broadcast_structure_t
+{
+	/// Indicates whether the vertex has a message for broadcast
+	bool has_broadcast_message;
+	/// Contains the message to broadcast
+	IP_MESSAGE_TYPE broadcast_message;
+};
+/// Contains the broadcast attributes for all vertices
+struct ip_broadcast_structure_t* ip_all_broadcast_structures = NULL;
+/// This structure defines the structure of a vertex.
+struct ip_vertex_t
+{
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_IDS
+		/// Contains the identifiers of the out-neighbours
+		IP_VERTEX_ID_TYPE* out_neighbours;
+	#endif // IP_NEEDS_OUT_NEIGHBOUR_IDS
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+		/// Contains the identifiers of the in-neighbours
+		IP_VERTEX_ID_TYPE* in_neighbours;
+	#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+		/// Contains the number of out-neighbours
+		IP_NEIGHBOUR_COUNT_TYPE out_neighbour_count;
+	#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_COUNT
+		/// Contains the number of in-neighbours
+		IP_NEIGHBOUR_COUNT_TYPE in_neighbour_count;
+	#endif // IP_NEEDS_IN_NEIGHBOUR_COUNT
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+		/// Contains the weights of out-edges
+		IP_EDGE_WEIGHT_TYPE* out_neighbour_weights;
+	#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+		/// Contains the weights of the in-neighbours
+		IP_EDGE_WEIGHT_TYPE* in_neighbour_weights;
+	#endif // IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+	/// Indicates whether the vertex has received messages from last superstep
+	bool has_message;
+	/// The vertex identifier
+	IP_VERTEX_ID_TYPE id;
+	/// Contains the combined message made from messages received from last superstep
+	IP_MESSAGE_TYPE message;
+	/// Contains the user-defined value
+	IP_VALUE_TYPE value;
+};
+
+/**
+ * @brief This function adds the given vertex to the list of vertices to execute
+ * at next superstep.
+ * @param[in] id The identifier of the vertex to executed next superstep.
+ * @post The vertex identifier by \p id will be executed at next superstep.
+ **/
+void ip_add_spread_vertex(IP_VERTEX_ID_TYPE id);
+/**
+ * @brief This function picks the direction of the superstep about to start.
+ * @details The decision follows the heuristics of direction-optimising
+ * breadth-first search: pull as soon as the vertices to execute cover a large
+ * enough share of the edges, and push again once they are few enough.
+ * @param[in] vertices_count The number of vertices to execute.
+ * @param[in] edges_count The number of out-edges of the vertices to execute.
+ * @post ip_direction contains the direction to use.
+ **/
+void ip_select_direction(size_t vertices_count, size_t edges_count);
+/**
+ * @brief This functions gathers and combines all the messages destined to the
+ * vertex \p v when pulling.
+ * @details Both the messages pushed with ip_send_message() and the broadcasts
+ * of the in-neighbours are combined.
+ * @param[inout] v The vertex to update.
+ * @pre \p v points to an allocated memory area containing a vertex.
+ * @post All the messages destined to vertex \p v are stored in v, and \p v is
+ * in the list of vertices to execute next superstep if it has any.
+ **/
+void ip_fetch_broadcast_messages(struct ip_vertex_t* v);
+
+#endif // COMBINER_HYBRID_PREAMBLE_H_INCLUDED
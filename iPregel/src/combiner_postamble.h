@@ -21,65 +21,103 @@
 #include <omp.h>
 #include <string.h>
 
+size_t ip_get_mailbox_slot(size_t superstep)
+{
+	return superstep % 2;
+}
+
 bool ip_has_message(struct ip_vertex_t* v)
 {
-	return v->has_message;
+	return atomic_load_explicit(&v->has_message[ip_get_mailbox_slot(ip_get_superstep())], memory_order_relaxed) == IP_MAILBOX_FULL;
 }
 
 bool ip_get_next_message(struct ip_vertex_t* v, IP_MESSAGE_TYPE* message_value)
 {
-	if(v->has_message)
+	size_t slot = ip_get_mailbox_slot(ip_get_superstep());
+	if(atomic_load_explicit(&v->has_message[slot], memory_order_relaxed) == IP_MAILBOX_FULL)
 	{
-		*message_value = v->message;
-		v->has_message = false;
+		*message_value = v->message[slot];
+		ip_empty_mailbox(&v->has_message[slot], &v->message[slot]);
 		return true;
 	}
 
 	return false;
 }
 
-void ip_cas(struct ip_vertex_t* dest_vertex, IP_VERTEX_ID_TYPE message)
+void ip_send_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
 {
-	IP_MESSAGE_TYPE old_value = dest_vertex->message_next;
-	IP_MESSAGE_TYPE new_value = old_value;
-	ip_combine(&new_value, message);
-	while(new_value != old_value && !atomic_compare_exchange_strong(&dest_vertex->message_next, &old_value, new_value))
+	#ifdef IP_USE_PROPAGATION_BLOCKING
+		ip_bin_message(id, message);
+	#else
+		#ifdef IP_USE_HUB_MAILBOXES
+			if(ip_has_hub_mailboxes(id))
+			{
+				ip_deliver_to_hub_mailbox(id, message);
+				return;
+			}
+		#endif // ifdef IP_USE_HUB_MAILBOXES
+		struct ip_vertex_t* temp_vertex = ip_get_vertex_by_id(id);
+		size_t slot = ip_get_mailbox_slot(ip_get_superstep() + 1);
+		if(ip_deliver_message(&temp_vertex->has_message[slot], &temp_vertex->message[slot], message))
+		{
+			ip_add_to_next_frontier(temp_vertex - ip_get_vertex_by_location(0));
+		}
+	#endif // ifdef IP_USE_PROPAGATION_BLOCKING
+}
+
+#if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES)
+	void ip_deliver_binned_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
 	{
-		old_value = dest_vertex->message_next;
-		new_value = old_value;
-		ip_combine(&new_value, message);
+		struct ip_vertex_t* temp_vertex = ip_get_vertex_by_id(id);
+		size_t slot = ip_get_mailbox_slot(ip_get_superstep() + 1);
+		if(ip_deliver_message_exclusively(&temp_vertex->has_message[slot], &temp_vertex->message[slot], message))
+		{
+			ip_add_to_next_frontier(temp_vertex - ip_get_vertex_by_location(0));
+		}
 	}
-}
+#endif // if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES)
 
-void ip_send_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
+void ip_add_to_next_frontier(size_t location)
 {
-	struct ip_vertex_t* temp_vertex = ip_get_vertex_by_id(id);
-	if(temp_vertex->has_message_next)
+	uint64_t mask = ((uint64_t)1) << (location % 64);
+	_Atomic uint64_t* word = &ip_all_frontiers[ip_get_mailbox_slot(ip_get_superstep() + 1)][location / 64];
+	// Most of the time the bit is already set by an earlier sender, there is no need to lock the cache line for it.
+	if((atomic_load_explicit(word, memory_order_relaxed) & mask) == 0 && (atomic_fetch_or_explicit(word, mask, memory_order_relaxed) & mask) == 0)
 	{
-		ip_cas(temp_vertex, message);
+		ip_all_thread_contexts[ip_my_thread_num].next_frontier_count++;
 	}
-	else
+}
+
+void ip_compute_frontier_word(size_t word_index, uint64_t bits)
+{
+	size_t slot = ip_get_mailbox_slot(ip_get_superstep());
+	while(bits != 0)
 	{
-		ip_lock_acquire(&temp_vertex->lock);
-		if(temp_vertex->has_message_next)
+		size_t location = word_index * 64 + __builtin_ctzll(bits);
+		bits &= bits - 1;
+		struct ip_vertex_t* temp_vertex = ip_get_vertex_by_location(location);
+		temp_vertex->active = true;
+		ip_compute(temp_vertex);
+		// Leave the slot read empty for the messages of next superstep.
+		if(ip_has_message(temp_vertex))
 		{
-			// During the time we were waiting to acquire the lock, someone else was having the lock and wrote the first value in the temp_vertex mailbox.
-			// We can release the lock and do the CAS combination straight away
-			ip_lock_release(&temp_vertex->lock);
-			ip_cas(temp_vertex, message);
+			ip_empty_mailbox(&temp_vertex->has_message[slot], &temp_vertex->message[slot]);
 		}
-		else
+		if(temp_vertex->active)
 		{
-			// We are still the first one waiting to write in that vertex mailbox
-			temp_vertex->message_next = message;
-			temp_vertex->has_message_next = true;
-			ip_lock_release(&temp_vertex->lock);
+			ip_add_to_next_frontier(location);
 		}
 	}
 }
 
 void ip_broadcast(struct ip_vertex_t* v, IP_MESSAGE_TYPE message)
 {
+	#ifdef IP_USE_HUB_BROADCASTS
+		if(ip_defer_hub_broadcast(v, message))
+		{
+			return;
+		}
+	#endif // ifdef IP_USE_HUB_BROADCASTS
 	for(IP_NEIGHBOUR_COUNT_TYPE i = 0; i < v->out_neighbour_count; i++)
 	{
 		ip_send_message(v->out_neighbours[i], message);
@@ -92,8 +130,8 @@ void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
 	{
 		ip_all_vertices[i].id = i;
 		ip_all_vertices[i].active = true;
-		ip_all_vertices[i].has_message = false;
-		ip_all_vertices[i].has_message_next = false;
+		ip_empty_mailbox(&ip_all_vertices[i].has_message[0], &ip_all_vertices[i].message[0]);
+		ip_empty_mailbox(&ip_all_vertices[i].has_message[1], &ip_all_vertices[i].message[1]);
 		#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
 			ip_all_vertices[i].out_neighbour_count = 0;
 		#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
@@ -112,12 +150,29 @@ void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
 		#ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
 			ip_all_vertices[i].in_neighbour_weights = NULL;
 		#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHT
-		ip_lock_init(&ip_all_vertices[i].lock);
 	}
 }
 
+void ip_init_thread_context(struct ip_thread_context_t* context)
+{
+	context->next_frontier_count = 0;
+}
+
 void ip_init_specific()
 {
+	ip_frontier_words_count = (ip_get_vertices_count() + 63) / 64;
+	ip_all_frontiers[0] = (_Atomic uint64_t*)ip_safe_malloc(sizeof(_Atomic uint64_t) * ip_frontier_words_count);
+	ip_all_frontiers[1] = (_Atomic uint64_t*)ip_safe_malloc(sizeof(_Atomic uint64_t) * ip_frontier_words_count);
+	// All vertices are executed at superstep 0.
+	for(size_t i = 0; i < ip_frontier_words_count; i++)
+	{
+		atomic_init(&ip_all_frontiers[0][i], UINT64_MAX);
+		atomic_init(&ip_all_frontiers[1][i], 0);
+	}
+	if(ip_get_vertices_count() % 64 != 0)
+	{
+		atomic_init(&ip_all_frontiers[0][ip_frontier_words_count - 1], (((uint64_t)1) << (ip_get_vertices_count() % 64)) - 1);
+	}
 }
 
 int ip_run()
@@ -127,10 +182,16 @@ int ip_run()
 	double timer_superstep_stop = 0;
 
 	#pragma omp parallel default(none) shared(ip_active_vertices, \
+											  ip_use_edge_stealing, \
+											  ip_all_frontiers, \
+											  ip_frontier_words_count, \
+											  ip_all_thread_contexts, \
+											  ip_thread_count, \
 											  timer_superstep_total, \
 											  timer_superstep_start, \
 											  timer_superstep_stop)
 	{
+		ip_my_thread_num = omp_get_thread_num();
 		while(ip_active_vertices != 0)
 		{
 			// This barrier is crucial; otherwise a thread may enter the single, change ip_active_vertices before one other thread has entered the loop. Thus the single would never complete.
@@ -146,48 +207,90 @@ int ip_run()
 				ip_active_vertices = 0;
 			}
 
-			struct ip_vertex_t* temp_vertex = NULL;
-
-			#pragma omp for reduction(+:ip_active_vertices) schedule(runtime)
-			for(size_t i = 0; i < ip_get_vertices_count(); i++)
+			_Atomic uint64_t* frontier = ip_all_frontiers[ip_get_mailbox_slot(ip_get_superstep())];
+			if(ip_use_edge_stealing)
 			{
-				temp_vertex = ip_get_vertex_by_location(i);
-				if(temp_vertex->active || ip_has_message(temp_vertex))
+				size_t chunk_first;
+				size_t chunk_last;
+				ip_prepare_chunks(NULL, ip_get_vertices_count());
+				while(ip_get_next_chunk(&chunk_first, &chunk_last))
 				{
-					temp_vertex->active = true;
-					ip_compute(temp_vertex);
-					if(temp_vertex->active)
+					for(size_t i = chunk_first / 64; chunk_first < chunk_last && i <= (chunk_last - 1) / 64; i++)
 					{
-						ip_active_vertices++;
+						// Chunks are not aligned on words, so only the bits of this chunk are taken from the word.
+						uint64_t mask = UINT64_MAX;
+						if(i == chunk_first / 64)
+						{
+							mask &= UINT64_MAX << (chunk_first % 64);
+						}
+						if(i == (chunk_last - 1) / 64 && chunk_last % 64 != 0)
+						{
+							mask &= UINT64_MAX >> (64 - chunk_last % 64);
+						}
+						uint64_t bits = atomic_load_explicit(&frontier[i], memory_order_relaxed) & mask;
+						if(bits != 0)
+						{
+							atomic_fetch_and_explicit(&frontier[i], ~bits, memory_order_relaxed);
+							ip_compute_frontier_word(i, bits);
+						}
 					}
 				}
+				// Replaces the implicit barrier of the OpenMP for below.
+				#pragma omp barrier
 			}
-
-			// Take in account the number of vertices that halted.
-			// Swap the message boxes for next superstep.
-			#pragma omp for reduction(+:ip_active_vertices) schedule(runtime)
-			for(size_t i = 0; i < ip_get_vertices_count(); i++)
+			else
 			{
-				temp_vertex = ip_get_vertex_by_location(i);
-				if(temp_vertex->has_message_next)
+				#pragma omp for schedule(runtime)
+				for(size_t i = 0; i < ip_frontier_words_count; i++)
 				{
-					temp_vertex->has_message = true;
-					temp_vertex->message = temp_vertex->message_next;
-					temp_vertex->has_message_next = false;
-					if(!temp_vertex->active)
+					uint64_t bits = atomic_load_explicit(&frontier[i], memory_order_relaxed);
+					if(bits != 0)
 					{
-						temp_vertex->active = true;
-						ip_active_vertices++;
+						// Nobody else writes the frontier of the current superstep, it is cleared to become the frontier of superstep after next.
+						atomic_store_explicit(&frontier[i], 0, memory_order_relaxed);
+						ip_compute_frontier_word(i, bits);
 					}
 				}
 			}
 
+			#ifdef IP_USE_HUB_BROADCASTS
+				//////////////////////////
+				// HUB BROADCAST PHASE //
+				////////////////////////
+				ip_run_hub_broadcasts();
+			#endif // ifdef IP_USE_HUB_BROADCASTS
+
+			#ifdef IP_USE_HUB_MAILBOXES
+				////////////////////////
+				// HUB MAILBOX PHASE //
+				//////////////////////
+				// Every hub gets the combination of the partial mailboxes that threads filled for it.
+				ip_combine_hub_mailboxes();
+			#endif // ifdef IP_USE_HUB_MAILBOXES
+
+			#ifdef IP_USE_PROPAGATION_BLOCKING
+				// Deliver the messages binned during the compute phase.
+				ip_apply_bins();
+			#endif // ifdef IP_USE_PROPAGATION_BLOCKING
+
+			#ifdef IP_NEEDS_REMOTE_VALUES
+				ip_commit_values();
+			#endif // ifdef IP_NEEDS_REMOTE_VALUES
+
+			// The barrier ending the phase above guarantees that all threads are done adding vertices to the frontier of next superstep.
 			#pragma omp single
 			{
+				// Every vertex in the frontier of next superstep was added by exactly one thread.
+				for(int i = 0; i < ip_thread_count; i++)
+				{
+					ip_active_vertices += ip_all_thread_contexts[i].next_frontier_count;
+					ip_all_thread_contexts[i].next_frontier_count = 0;
+				}
 				timer_superstep_stop = omp_get_wtime();
 				timer_superstep_total += timer_superstep_stop - timer_superstep_start;
 				printf("Superstep%zuDuration:%f\n", ip_get_superstep(), timer_superstep_stop - timer_superstep_start);
 				printf("Superstep%zuActiveVertexCount:%zu\n", ip_get_superstep(), ip_active_vertices);
+				ip_reduce_aggregators();
 				ip_increment_superstep();
  			} // End of OpenMP single region
 		} // End of superstep processing loop
@@ -195,6 +298,14 @@ int ip_run()
 
 	printf("Total time of supersteps: %fs.\n", timer_superstep_total);
 
+	// Free and clean program.
+	#ifdef IP_USE_HUB_BROADCASTS
+		ip_free_hub_broadcasts();
+	#endif // ifdef IP_USE_HUB_BROADCASTS
+	#ifdef IP_USE_HUB_MAILBOXES
+		ip_free_hub_mailboxes();
+	#endif // ifdef IP_USE_HUB_MAILBOXES
+
 	return 0;
 }
 
@@ -203,22 +314,4 @@ void ip_vote_to_halt(struct ip_vertex_t* v)
 	v->active = false;
 }
 
-
-void ip_lock_init(IP_LOCK_TYPE* lock)
-{
-	*lock = 0;
-}
-
-void ip_lock_acquire(IP_LOCK_TYPE* lock)
-{
-	int zero = 0;
-	while(!atomic_compare_exchange_strong(lock, &zero, 1))
-		zero = 0;
-}
-
-void ip_lock_release(IP_LOCK_TYPE* lock)
-{
-	atomic_store(lock, 0);
-}
-
 #endif // COMBINER_POSTAMBLE_H_INCLUDED
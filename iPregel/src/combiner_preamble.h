@@ -29,8 +29,6 @@
 #include <stdatomic.h> 
 
 // Global variables
-/// The data structure representing a lock.
-typedef volatile atomic_int IP_LOCK_TYPE;	
 /// This structure defines the structure of a vertex.
 struct ip_vertex_t
 {
@@ -60,36 +58,50 @@ struct ip_vertex_t
 	#endif // IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
 	/// Contains the vertex status
 	bool active;
-	/// Indicates whether the vertex has received messages during the previous superstep
-	bool has_message;
-	/// Indicates whether the vertex has received message during the current superstep so far
-	atomic_bool has_message_next;
-	/// Mailbox lock
-	IP_LOCK_TYPE lock;
+	/// Indicates whether the vertex has received messages, the slot of the previous superstep is read while the other is written; see ip_get_mailbox_slot()
+	IP_MAILBOX_FLAG_TYPE has_message[2];
 	/// Contains the vertex identifier
 	IP_VERTEX_ID_TYPE id;
-	/// Contains the combined message resulting from messages received during previous superstep
-	IP_MESSAGE_TYPE message;
-	/// Contains the combined message resulting from messages received during current superstep so far
-	IP_MESSAGE_TYPE message_next;
+	/// Contains the combined messages received, indexed like has_message
+	IP_MESSAGE_TYPE message[2];
 	/// Contains the user-defined value
 	IP_VALUE_TYPE value;
 };
+/// This structure holds the data that a thread uses during a superstep.
+struct ip_thread_context_t
+{
+	/// The number of vertices that the thread added to the frontier of next superstep.
+	_Alignas(IP_CACHE_LINE_SIZE) size_t next_frontier_count;
+};
+/// The number of 64-bit words in a frontier bitmap.
+size_t ip_frontier_words_count = 0;
+/// The vertices to execute, one bitmap per superstep parity: the bitmap of the current superstep is read while the other one is filled for next superstep.
+_Atomic uint64_t* ip_all_frontiers[2] = {NULL, NULL};
 
 /**
- * @brief This function initialises the lock \p lock.
- * @param[in] lock The lock to initialise.
+ * @brief This function returns the mailbox slot that is read at the superstep
+ * \p superstep.
+ * @details Mailboxes are double-buffered by superstep parity: the messages
+ * sent during a superstep go to the slot read at the next one. A slot is
+ * emptied right after its vertex is computed, so the slot written is always
+ * empty at the beginning of a superstep and no swap pass is needed.
+ * @param[in] superstep The superstep number.
+ * @return The slot to read, the other one being written.
  **/
-void ip_lock_init(IP_LOCK_TYPE* lock);
+size_t ip_get_mailbox_slot(size_t superstep);
 /**
- * @brief This function acquires the lock \p lock.
- * @param[in] lock The lock to acquire.
+ * @brief This function adds the vertex at location \p location to the
+ * frontier of next superstep.
+ * @param[in] location The location of the vertex.
+ * @post The next_frontier_count of the calling thread is incremented if the
+ * vertex was not already in that frontier.
  **/
-void ip_lock_acquire(IP_LOCK_TYPE* lock);
+void ip_add_to_next_frontier(size_t location);
 /**
- * @brief This function releases the lock \p lock.
- * @param[in] lock The lock to release.
+ * @brief This function executes the vertices whose bit is set in \p bits.
+ * @param[in] word_index The index of the frontier word \p bits comes from.
+ * @param[in] bits The bits of the vertices to execute.
  **/
-void ip_lock_release(IP_LOCK_TYPE* lock);
+void ip_compute_frontier_word(size_t word_index, uint64_t bits);
 
 #endif // COMBINER_PREAMBLE_H_INCLUDED
@@ -20,9 +20,6 @@
 
 #include <omp.h>
 
-int ip_my_thread_num;
-#pragma omp threadprivate(ip_my_thread_num)
-
 bool ip_has_message(struct ip_vertex_t* v)
 {
 	return v->has_message;
@@ -41,15 +38,54 @@ bool ip_get_next_message(struct ip_vertex_t* v, IP_MESSAGE_TYPE* message_value)
 
 void ip_send_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
 {
-	(void)(id);
-	(void)(message);
-	printf("The function send_message should not be used in the SINGLE_BROADCAST \
+	#ifdef IP_USE_SIDE_MAILBOXES
+		ip_bin_message(id, message);
+	#else
+		(void)(id);
+		(void)(message);
+		printf("The function send_message should not be used in the SINGLE_BROADCAST \
 version; only broadcast() should be called, and once per superstep maximum.\n");
-	exit(-1);
+		exit(-1);
+	#endif // ifdef IP_USE_SIDE_MAILBOXES
 }
 
+#ifdef IP_USE_SIDE_MAILBOXES
+	void ip_deliver_binned_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
+	{
+		struct ip_vertex_t* temp_vertex = ip_get_vertex_by_id(id);
+		if(temp_vertex->has_message)
+		{
+			ip_combine(&temp_vertex->message, message);
+		}
+		else
+		{
+			if(!temp_vertex->active)
+			{
+				ip_all_thread_contexts[ip_my_thread_num].activated_vertices_count++;
+				temp_vertex->active = true;
+			}
+			temp_vertex->has_message = true;
+			temp_vertex->message = message;
+		}
+	}
+#endif // ifdef IP_USE_SIDE_MAILBOXES
+
 void ip_broadcast(struct ip_vertex_t* v, IP_MESSAGE_TYPE message)
 {
+	#ifdef IP_USE_SPARSE_PULL
+		if(!ip_all_neighbour_extras[v->id].has_broadcast_message)
+		{
+			struct ip_thread_context_t* my_context = &ip_all_thread_contexts[ip_my_thread_num];
+			if(my_context->broadcasters_count == my_context->broadcasters_max_size)
+			{
+				my_context->broadcasters_max_size *= 2;
+				my_context->broadcasters = ip_safe_realloc(my_context->broadcasters, sizeof(size_t) * my_context->broadcasters_max_size);
+			}
+			my_context->broadcasters[my_context->broadcasters_count] = v - ip_get_vertex_by_location(0);
+			my_context->broadcasters_count++;
+			my_context->broadcast_edges_count += v->out_neighbour_count;
+		}
+	#endif // ifdef IP_USE_SPARSE_PULL
 	ip_all_neighbour_extras[v->id].has_broadcast_message = true;
 	ip_all_neighbour_extras[v->id].broadcast_message = message;
 }
@@ -70,8 +106,7 @@ void ip_fetch_broadcast_messages(struct ip_vertex_t* v)
 	{
 		if(!v->active)
 		{
-			#pragma omp atomic
-			ip_active_vertices++;
+			ip_all_thread_contexts[ip_my_thread_num].activated_vertices_count++;
 			v->active = true;
 		}
 		v->has_message = true;
@@ -88,6 +123,73 @@ void ip_fetch_broadcast_messages(struct ip_vertex_t* v)
 	}	
 }
 
+#ifdef IP_USE_SPARSE_PULL
+	bool ip_select_pulling_vertices()
+	{
+		size_t broadcast_edges_count = 0;
+		for(int i = 0; i < ip_thread_count; i++)
+		{
+			broadcast_edges_count += ip_all_thread_contexts[i].broadcast_edges_count;
+		}
+		if(broadcast_edges_count * IP_SPARSE_PULL_RATIO >= ip_get_edges_count())
+		{
+			return false;
+		}
+
+		struct ip_thread_context_t* my_context = &ip_all_thread_contexts[ip_my_thread_num];
+		struct ip_vertex_t* first_vertex = ip_get_vertex_by_location(0);
+		for(size_t i = 0; i < my_context->broadcasters_count; i++)
+		{
+			struct ip_vertex_t* v = ip_get_vertex_by_location(my_context->broadcasters[i]);
+			for(IP_NEIGHBOUR_COUNT_TYPE j = 0; j < v->out_neighbour_count; j++)
+			{
+				size_t location = ip_get_vertex_by_id(v->out_neighbours[j]) - first_vertex;
+				uint64_t mask = ((uint64_t)1) << (location % 64);
+				// Vertices reached by several broadcasts need their bit set once only, there is no need to lock the cache line again.
+				if((atomic_load_explicit(&ip_pulling_vertices[location / 64], memory_order_relaxed) & mask) == 0)
+				{
+					atomic_fetch_or_explicit(&ip_pulling_vertices[location / 64], mask, memory_order_relaxed);
+				}
+			}
+		}
+		// All vertices that pull must be marked before any of them pulls.
+		#pragma omp barrier
+		return true;
+	}
+
+	void ip_fetch_sparse_broadcast_messages()
+	{
+		#pragma omp for schedule(runtime)
+		for(size_t i = 0; i < ip_pulling_vertices_words_count; i++)
+		{
+			uint64_t bits = atomic_load_explicit(&ip_pulling_vertices[i], memory_order_relaxed);
+			if(bits != 0)
+			{
+				// Only this thread reads this word, it is cleared for the next superstep that pulls sparsely.
+				atomic_store_explicit(&ip_pulling_vertices[i], 0, memory_order_relaxed);
+				while(bits != 0)
+				{
+					size_t location = i * 64 + __builtin_ctzll(bits);
+					bits &= bits - 1;
+					ip_fetch_broadcast_messages(ip_get_vertex_by_location(location));
+				}
+				#ifdef IP_ENABLE_THREAD_PROFILING
+					ip_all_thread_contexts[ip_my_thread_num].timer_fetching_stop = omp_get_wtime();
+				#endif
+			}
+		}
+	}
+
+	void ip_reset_broadcasters()
+	{
+		for(int i = 0; i < ip_thread_count; i++)
+		{
+			ip_all_thread_contexts[i].broadcasters_count = 0;
+			ip_all_thread_contexts[i].broadcast_edges_count = 0;
+		}
+	}
+#endif // ifdef IP_USE_SPARSE_PULL
+
 void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
 {
 	for(IP_VERTEX_ID_TYPE i = first; i <= last; i++)
@@ -117,9 +219,28 @@ void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
 	}
 }
 
+void ip_init_thread_context(struct ip_thread_context_t* context)
+{
+	context->activated_vertices_count = 0;
+	#ifdef IP_USE_SPARSE_PULL
+		context->broadcasters_max_size = 1;
+		context->broadcasters_count = 0;
+		context->broadcasters = ip_safe_malloc(sizeof(size_t) * context->broadcasters_max_size);
+		context->broadcast_edges_count = 0;
+	#endif // ifdef IP_USE_SPARSE_PULL
+}
+
 void ip_init_specific()
 {
 	ip_all_neighbour_extras = (struct ip_neighbour_extra_t*)ip_safe_malloc(sizeof(struct ip_neighbour_extra_t) * ip_get_vertices_count());
+	#ifdef IP_USE_SPARSE_PULL
+		ip_pulling_vertices_words_count = (ip_get_vertices_count() + 63) / 64;
+		ip_pulling_vertices = (_Atomic uint64_t*)ip_safe_malloc(sizeof(_Atomic uint64_t) * ip_pulling_vertices_words_count);
+		for(size_t i = 0; i < ip_pulling_vertices_words_count; i++)
+		{
+			atomic_init(&ip_pulling_vertices[i], 0);
+		}
+	#endif // ifdef IP_USE_SPARSE_PULL
 }
 
 int ip_run()
@@ -129,29 +250,16 @@ int ip_run()
 	double timer_superstep_stop = 0;
 
 	#ifdef IP_ENABLE_THREAD_PROFILING
-		double* timer_compute_start = malloc(sizeof(double) * ip_thread_count);
-		double* timer_compute_stop = malloc(sizeof(double) * ip_thread_count);
-		double* timer_compute_total = malloc(sizeof(double) * ip_thread_count);
-		double* timer_fetching_start = malloc(sizeof(double) * ip_thread_count);
-		double* timer_fetching_stop = malloc(sizeof(double) * ip_thread_count);
-		double* timer_fetching_total = malloc(sizeof(double) * ip_thread_count);
-	#endif
-
-	#ifdef IP_ENABLE_THREAD_PROFILING
-		#pragma omp parallel default(none) shared(ip_active_vertices, \
+		#pragma omp parallel default(none) shared(ip_all_thread_contexts, \
+												  ip_active_vertices, \
 												  ip_all_neighbour_extras, \
 												  ip_thread_count, \
-												  timer_compute_start, \
-												  timer_compute_stop, \
-												  timer_compute_total, \
-												  timer_fetching_start, \
-												  timer_fetching_stop, \
-												  timer_fetching_total, \
 												  timer_superstep_total, \
 												  timer_superstep_start, \
 												  timer_superstep_stop)
 	#else
-		#pragma omp parallel default(none) shared(ip_active_vertices, \
+		#pragma omp parallel default(none) shared(ip_all_thread_contexts, \
+												  ip_active_vertices, \
 												  ip_all_neighbour_extras, \
 												  ip_thread_count, \
 												  timer_superstep_total, \
@@ -179,7 +287,7 @@ int ip_run()
 			// COMPUTE PHASE //
 			//////////////////
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_compute_start[ip_my_thread_num] = omp_get_wtime();
+				ip_all_thread_contexts[ip_my_thread_num].timer_compute_start = omp_get_wtime();
 			#endif
 			struct ip_vertex_t* temp_vertex = NULL;
 			#pragma omp for reduction(+:ip_active_vertices) schedule(runtime)
@@ -190,17 +298,21 @@ int ip_run()
 				if(temp_vertex->active)
 				{
 					ip_compute(temp_vertex);
+					#ifdef IP_USE_SPARSE_PULL
+						// Only the vertices that pull get their message refreshed, this one must not be seen again.
+						temp_vertex->has_message = false;
+					#endif // ifdef IP_USE_SPARSE_PULL
 					if(temp_vertex->active)
 					{
 						ip_active_vertices++;
 					}
 				}
 				#ifdef IP_ENABLE_THREAD_PROFILING
-					timer_compute_stop[ip_my_thread_num] = omp_get_wtime();
+					ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop = omp_get_wtime();
 				#endif
 			}
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_compute_total[ip_my_thread_num] = timer_compute_stop[ip_my_thread_num] - timer_compute_start[ip_my_thread_num];
+				ip_all_thread_contexts[ip_my_thread_num].timer_compute_total = ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop - ip_all_thread_contexts[ip_my_thread_num].timer_compute_start;
 			#endif
 
 			/////////////////////////////
@@ -208,22 +320,49 @@ int ip_run()
 			///////////////////////////
 			// Get the messages broadcasted by neighbours.
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_fetching_start[ip_my_thread_num] = omp_get_wtime();
+				ip_all_thread_contexts[ip_my_thread_num].timer_fetching_start = omp_get_wtime();
 			#endif
-			#pragma omp for schedule(runtime)
-			for(size_t i = 0; i < ip_get_vertices_count(); i++)
+			#ifdef IP_USE_SPARSE_PULL
+				if(ip_select_pulling_vertices())
+				{
+					// Only the out-neighbours of the vertices that broadcast may have a message.
+					ip_fetch_sparse_broadcast_messages();
+				}
+				else
+			#endif // ifdef IP_USE_SPARSE_PULL
 			{
-				ip_fetch_broadcast_messages(ip_get_vertex_by_location(i));
-				#ifdef IP_ENABLE_THREAD_PROFILING
-					timer_fetching_stop[ip_my_thread_num] = omp_get_wtime();
-				#endif
+				#pragma omp for schedule(runtime)
+				for(size_t i = 0; i < ip_get_vertices_count(); i++)
+				{
+					ip_fetch_broadcast_messages(ip_get_vertex_by_location(i));
+					#ifdef IP_ENABLE_THREAD_PROFILING
+						ip_all_thread_contexts[ip_my_thread_num].timer_fetching_stop = omp_get_wtime();
+					#endif
+				}
 			}
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_fetching_total[ip_my_thread_num] = timer_fetching_stop[ip_my_thread_num] - timer_fetching_start[ip_my_thread_num];
+				ip_all_thread_contexts[ip_my_thread_num].timer_fetching_total = ip_all_thread_contexts[ip_my_thread_num].timer_fetching_stop - ip_all_thread_contexts[ip_my_thread_num].timer_fetching_start;
 			#endif
+
+			#ifdef IP_USE_SIDE_MAILBOXES
+				//////////////////////////////////
+				// SIDE MAILBOX DELIVERY PHASE //
+				////////////////////////////////
+				// The messages sent to a given vertex are combined into the mailboxes that the fetching phase filled.
+				ip_apply_bins();
+			#endif // ifdef IP_USE_SIDE_MAILBOXES
 			
+			#ifdef IP_NEEDS_REMOTE_VALUES
+				ip_commit_values();
+			#endif // ifdef IP_NEEDS_REMOTE_VALUES
 			#pragma omp single
 			{
+				// The implicit barrier of the OpenMP fors above guarantees that all threads are done activating vertices.
+				for(int i = 0; i < ip_thread_count; i++)
+				{
+					ip_active_vertices += ip_all_thread_contexts[i].activated_vertices_count;
+					ip_all_thread_contexts[i].activated_vertices_count = 0;
+				}
 				timer_superstep_stop = omp_get_wtime();
 				timer_superstep_total += timer_superstep_stop - timer_superstep_start;
 				printf("Superstep%zuDuration:%f\n", ip_get_superstep(), timer_superstep_stop - timer_superstep_start);
@@ -234,10 +373,14 @@ int ip_run()
 					printf("+-----+------------+----------+-----------+\n");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf("| %3d |   %8.3f | %8.3f |  %8.3f |\n", i, timer_compute_total[i], timer_fetching_total[i], timer_compute_total[i] + timer_fetching_total[i]);
+						printf("| %3d |   %8.3f | %8.3f |  %8.3f |\n", i, ip_all_thread_contexts[i].timer_compute_total, ip_all_thread_contexts[i].timer_fetching_total, ip_all_thread_contexts[i].timer_compute_total + ip_all_thread_contexts[i].timer_fetching_total);
 					}
 					printf("+-----+------------+----------+-----------+\n");
 				#endif
+				#ifdef IP_USE_SPARSE_PULL
+					ip_reset_broadcasters();
+				#endif // ifdef IP_USE_SPARSE_PULL
+				ip_reduce_aggregators();
 				ip_increment_superstep();
  			} // End of OpenMP single region
 		} // End of superstep processing loop
@@ -245,15 +388,10 @@ int ip_run()
 
 	printf("Total time of supersteps: %fs.\n", timer_superstep_total);
 
-	#ifdef IP_ENABLE_THREAD_PROFILING
-		free(timer_compute_start);
-		free(timer_compute_stop);
-		free(timer_compute_total);
-		free(timer_fetching_start);
-		free(timer_fetching_stop);
-		free(timer_fetching_total);
-	#endif
 	free(ip_all_neighbour_extras);
+	#ifdef IP_USE_SPARSE_PULL
+		ip_safe_free(ip_pulling_vertices);
+	#endif // ifdef IP_USE_SPARSE_PULL
 	
 	return 0;
 }
@@ -37,6 +37,21 @@
 	#define IP_NEEDS_IN_NEIGHBOUR_COUNT
 #endif // ifndef IP_NEEDS_IN_NEIGHBOUR_COUNT
 
+#ifdef IP_USE_SPARSE_PULL
+	#ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
+		#define IP_NEEDS_OUT_NEIGHBOUR_IDS
+	#endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
+
+	#ifndef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+		#define IP_NEEDS_OUT_NEIGHBOUR_COUNT
+	#endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+
+	#ifndef IP_SPARSE_PULL_RATIO
+		/// Only the out-neighbours of the vertices that broadcast pull when those have fewer than one out-edge in IP_SPARSE_PULL_RATIO.
+		#define IP_SPARSE_PULL_RATIO 20
+	#endif // ifndef IP_SPARSE_PULL_RATIO
+#endif // ifdef IP_USE_SPARSE_PULL
+
 // Global variables
 /// Structure containing the externalised vertex attributes
 struct ip_neighbour_extra_t
@@ -48,6 +63,36 @@ struct ip_neighbour_extra_t
  };
 /// Contains the externalised structure for all vertices
 struct ip_neighbour_extra_t* ip_all_neighbour_extras = NULL;
+/// This structure holds the state private to each thread; each instance sits on its own cache lines to avoid false sharing.
+struct ip_thread_context_t
+{
+	/// The number of vertices this thread activated at current superstep.
+	_Alignas(IP_CACHE_LINE_SIZE) size_t activated_vertices_count;
+	#ifdef IP_USE_SPARSE_PULL
+		/// The size of the broadcasters buffer. It is used for reallocation purpose.
+		size_t broadcasters_max_size;
+		/// The number of vertices this thread executed that broadcast at current superstep.
+		size_t broadcasters_count;
+		/// The locations of the vertices this thread executed that broadcast at current superstep.
+		size_t* broadcasters;
+		/// The number of out-edges of the vertices in broadcasters.
+		size_t broadcast_edges_count;
+	#endif // ifdef IP_USE_SPARSE_PULL
+	#ifdef IP_ENABLE_THREAD_PROFILING
+		/// The time at which this thread started the compute phase at current superstep.
+		double timer_compute_start;
+		/// The time at which this thread stopped the compute phase at current superstep.
+		double timer_compute_stop;
+		/// The time spent by this thread in the compute phase, accumulated over all supersteps.
+		double timer_compute_total;
+		/// The time at which this thread started fetching messages at current superstep.
+		double timer_fetching_start;
+		/// The time at which this thread stopped fetching messages at current superstep.
+		double timer_fetching_stop;
+		/// The time spent by this thread in fetching messages, accumulated over all supersteps.
+		double timer_fetching_total;
+	#endif // ifdef IP_ENABLE_THREAD_PROFILING
+};
 /**
  * @brief This structure defines the structure of a vertex.
  * @details The vertex structure does not contain the has_broadcast_message flag or broadcast_message to improve cache usage.
@@ -100,5 +145,38 @@ struct ip_vertex_t
  * @post All the messages destined to vertex \p v are stored in v.
  **/
 void ip_fetch_broadcast_messages(struct ip_vertex_t* v);
+#ifdef IP_USE_SPARSE_PULL
+	/// The number of 64-bit words in ip_pulling_vertices.
+	size_t ip_pulling_vertices_words_count = 0;
+	/// One bit per vertex location, set for the out-neighbours of the vertices that broadcast when only they pull.
+	_Atomic uint64_t* ip_pulling_vertices = NULL;
+	/**
+	 * @brief This function decides whether only the out-neighbours of the
+	 * vertices that broadcast at current superstep pull, and marks them if so.
+	 * @details They alone pull when the vertices that broadcast have fewer than
+	 * one out-edge in IP_SPARSE_PULL_RATIO; every thread then marks the
+	 * out-neighbours of the vertices that broadcast among those it executed.
+	 * This function contains an OpenMP barrier when it returns true and must
+	 * therefore be called by all threads of the team.
+	 * @retval true Only the vertices marked in ip_pulling_vertices must pull.
+	 * @retval false All vertices must pull.
+	 * @pre All threads are done computing the current superstep.
+	 **/
+	bool ip_select_pulling_vertices();
+	/**
+	 * @brief This function makes the vertices marked in ip_pulling_vertices
+	 * fetch their messages, and clears the marks.
+	 * @details This function contains an OpenMP for construct and must
+	 * therefore be called by all threads of the team.
+	 * @pre ip_select_pulling_vertices() returned true.
+	 **/
+	void ip_fetch_sparse_broadcast_messages();
+	/**
+	 * @brief This function forgets the vertices that broadcast at current
+	 * superstep.
+	 * @pre No thread reads the broadcasters of the others anymore.
+	 **/
+	void ip_reset_broadcasters();
+#endif // ifdef IP_USE_SPARSE_PULL
 
 #endif // SINGLE_BROADCAST_PREAMBLE_H_INCLUDED
@@ -21,11 +21,6 @@
 #include <omp.h>
 #include <string.h>
 
-#define IP_CACHE_LINE_LENGTH sizeof(void*)
-
-int ip_my_thread_num;
-#pragma omp threadprivate(ip_my_thread_num)
-
 bool ip_has_message(struct ip_vertex_t* v)
 {
 	return v->has_message;
@@ -45,10 +40,20 @@ bool ip_get_next_message(struct ip_vertex_t* v, IP_MESSAGE_TYPE* message_value)
 
 void ip_add_spread_vertex(IP_VERTEX_ID_TYPE id)
 {
-	struct ip_vertex_list_t* my_list = &ip_all_spread_vertices_omp[ip_my_thread_num * IP_CACHE_LINE_LENGTH];
+	#ifdef IP_USE_DENSE_FRONTIER
+		if(ip_dense_frontier_next)
+		{
+			size_t location = ip_get_vertex_by_id(id) - ip_get_vertex_by_location(0);
+			// The vertex is added by the first delivery into its mailbox only, so no other thread sets this bit.
+			atomic_fetch_or_explicit(&ip_dense_frontiers[(ip_get_superstep() + 1) % 2][location / 64], ((uint64_t)1) << (location % 64), memory_order_relaxed);
+			ip_all_thread_contexts[ip_my_thread_num].dense_spread_vertices_count++;
+			return;
+		}
+	#endif // ifdef IP_USE_DENSE_FRONTIER
+	struct ip_vertex_list_t* my_list = &ip_all_thread_contexts[ip_my_thread_num].spread_vertices;
 	if(my_list->size == my_list->max_size)
 	{
-		my_list->max_size++;
+		my_list->max_size *= 2;
 		my_list->data = ip_safe_realloc(my_list->data, sizeof(IP_VERTEX_ID_TYPE) * my_list->max_size);
 	}
 
@@ -56,49 +61,43 @@ void ip_add_spread_vertex(IP_VERTEX_ID_TYPE id)
 	my_list->size++;
 }
 
-void ip_cas(IP_VERTEX_ID_TYPE id, IP_VERTEX_ID_TYPE message)
-{
-	IP_MESSAGE_TYPE old_value = ip_all_externalised_structures[id].message_next;
-	IP_MESSAGE_TYPE new_value = old_value;
-	ip_combine(&new_value, message);
-	while(new_value != old_value && !atomic_compare_exchange_strong(&ip_all_externalised_structures[id].message_next, &old_value, new_value))
-	{
-		old_value = ip_all_externalised_structures[id].message_next;
-		new_value = old_value;
-		ip_combine(&new_value, message);
-	}
-}
-
-
 void ip_send_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
 {
-	if(ip_all_externalised_structures[id].has_message_next)
-	{
-		ip_cas(id, message);
-	}
-	else
-	{
-		ip_lock_acquire(&ip_all_externalised_structures[id].lock);
-		if(ip_all_externalised_structures[id].has_message_next)
+	#ifdef IP_USE_PROPAGATION_BLOCKING
+		ip_bin_message(id, message);
+	#else
+		#ifdef IP_USE_HUB_MAILBOXES
+			if(ip_has_hub_mailboxes(id))
+			{
+				ip_deliver_to_hub_mailbox(id, message);
+				return;
+			}
+		#endif // ifdef IP_USE_HUB_MAILBOXES
+		if(ip_deliver_message(&ip_all_externalised_structures[id].has_message_next, &ip_all_externalised_structures[id].message_next, message))
 		{
-			// During the time we were waiting to acquire the lock, someone else was having the lock and wrote the first value in the temp_vertex mailbox.
-			// We can release the lock and do the CAS combination straight away
-			ip_lock_release(&ip_all_externalised_structures[id].lock);
-			ip_cas(id, message);
+			ip_add_spread_vertex(id);
 		}
-		else
+	#endif // ifdef IP_USE_PROPAGATION_BLOCKING
+}
+
+#if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES)
+	void ip_deliver_binned_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
+	{
+		if(ip_deliver_message_exclusively(&ip_all_externalised_structures[id].has_message_next, &ip_all_externalised_structures[id].message_next, message))
 		{
-			// We are still the first one waiting to write in that vertex mailbox
-			ip_all_externalised_structures[id].message_next = message;
-			ip_all_externalised_structures[id].has_message_next = true;
-			ip_lock_release(&ip_all_externalised_structures[id].lock);
 			ip_add_spread_vertex(id);
 		}
 	}
-}
+#endif // if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES)
 
 void ip_broadcast(struct ip_vertex_t* v, IP_MESSAGE_TYPE message)
 {
+	#ifdef IP_USE_HUB_BROADCASTS
+		if(ip_defer_hub_broadcast(v, message))
+		{
+			return;
+		}
+	#endif // ifdef IP_USE_HUB_BROADCASTS
 	for(IP_NEIGHBOUR_COUNT_TYPE i = 0; i < v->out_neighbour_count; i++)
 	{
 		ip_send_message(v->out_neighbours[i], message);
@@ -111,7 +110,7 @@ void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
 	{
 		ip_all_vertices[i].id = i;
 		ip_all_vertices[i].has_message = false;
-		ip_all_externalised_structures[i].has_message_next = false;
+		ip_empty_mailbox(&ip_all_externalised_structures[i].has_message_next, &ip_all_externalised_structures[i].message_next);
 		#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
 			ip_all_vertices[i].out_neighbour_count = 0;
 		#endif // IP_NEEDS_OUT_NEIGHBOUR_COUNT
@@ -130,32 +129,503 @@ void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
 		#ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
 			ip_all_vertices[i].in_neighbour_weights = NULL;
 		#endif // IP_NEEDS_IN_NEIGHBOUR_WEIGHT
-		ip_lock_init(&ip_all_externalised_structures[i].lock);
 	}
 }
 
+void ip_init_thread_context(struct ip_thread_context_t* context)
+{
+	context->spread_vertices.max_size = 1;
+	context->spread_vertices.size = 0;
+	context->spread_vertices.data = ip_safe_malloc(sizeof(IP_VERTEX_ID_TYPE) * context->spread_vertices.max_size);
+	#ifdef IP_USE_ADAPTIVE_THREADS
+		context->spread_edges_count = 0;
+	#endif // ifdef IP_USE_ADAPTIVE_THREADS
+	#ifdef IP_USE_SORTED_FRONTIER
+		context->sorted_spread_vertices_count = 0;
+	#endif // ifdef IP_USE_SORTED_FRONTIER
+	#ifdef IP_USE_DENSE_FRONTIER
+		context->dense_spread_vertices_count = 0;
+	#endif // ifdef IP_USE_DENSE_FRONTIER
+}
+
 void ip_init_specific()
 {
-	// Initialise OpenMP variables
+	#ifdef IP_USE_SPIN_BARRIER
+		// A vertex is added at most once per superstep, so the merged list never needs to grow while threads write into it.
+		ip_all_spread_vertices.max_size = ip_get_vertices_count();
+	#else
+		ip_all_spread_vertices.max_size = 1;
+	#endif // ifdef IP_USE_SPIN_BARRIER
+	ip_all_spread_vertices.size = 0;
+	ip_all_spread_vertices.data = ip_safe_malloc(sizeof(IP_VERTEX_ID_TYPE) * ip_all_spread_vertices.max_size);
+	ip_all_externalised_structures = (struct ip_externalised_structure_t*)ip_safe_malloc(sizeof(struct ip_externalised_structure_t) * ip_get_vertices_count());
+	#ifdef IP_USE_SORTED_FRONTIER
+		ip_spread_bitmap_words_count = (ip_get_vertices_count() + 63) / 64;
+		ip_spread_bitmap = (_Atomic uint64_t*)ip_safe_malloc(sizeof(_Atomic uint64_t) * ip_spread_bitmap_words_count);
+		for(size_t i = 0; i < ip_spread_bitmap_words_count; i++)
+		{
+			atomic_init(&ip_spread_bitmap[i], 0);
+		}
+	#endif // ifdef IP_USE_SORTED_FRONTIER
+	#ifdef IP_USE_DENSE_FRONTIER
+		ip_dense_frontier_words_count = (ip_get_vertices_count() + 63) / 64;
+		ip_dense_frontiers[0] = (_Atomic uint64_t*)ip_safe_malloc(sizeof(_Atomic uint64_t) * ip_dense_frontier_words_count);
+		ip_dense_frontiers[1] = (_Atomic uint64_t*)ip_safe_malloc(sizeof(_Atomic uint64_t) * ip_dense_frontier_words_count);
+		for(size_t i = 0; i < ip_dense_frontier_words_count; i++)
+		{
+			atomic_init(&ip_dense_frontiers[0][i], 0);
+			atomic_init(&ip_dense_frontiers[1][i], 0);
+		}
+	#endif // ifdef IP_USE_DENSE_FRONTIER
+}
+
+#ifdef IP_USE_SPIN_BARRIER
+int ip_run()
+{
+	double timer_superstep_total = 0;
+	double timer_superstep_start = 0;
+	double timer_superstep_stop = 0;
+
+	#pragma omp parallel default(none) shared(ip_all_thread_contexts, \
+											  ip_active_vertices, \
+											  ip_use_edge_stealing, \
+											  ip_all_spread_vertices, \
+											  ip_thread_count, \
+											  ip_all_externalised_structures, \
+											  timer_superstep_total, \
+											  timer_superstep_start, \
+											  timer_superstep_stop)
+	{
+		ip_my_thread_num = omp_get_thread_num();
+		struct ip_vertex_list_t* my_list = &ip_all_thread_contexts[ip_my_thread_num].spread_vertices;
+		// Only the master thread reads the timers, no need to wait for it.
+		if(ip_my_thread_num == 0)
+		{
+			timer_superstep_start = omp_get_wtime();
+		}
+		// ip_active_vertices is only written by the master thread between the two barriers of a superstep, so all threads agree on the condition.
+		while(ip_is_first_superstep() || ip_active_vertices > 0)
+		{
+			////////////////////
+			// COMPUTE PHASE //
+			//////////////////
+			struct ip_vertex_t* temp_vertex = NULL;
+			if(ip_use_edge_stealing)
+			{
+				bool all_vertices = ip_is_first_superstep();
+				size_t chunk_first;
+				size_t chunk_last;
+				ip_prepare_chunks(all_vertices ? NULL : ip_all_spread_vertices.data, all_vertices ? ip_get_vertices_count() : ip_all_spread_vertices.size);
+				while(ip_get_next_chunk(&chunk_first, &chunk_last))
+				{
+					for(size_t i = chunk_first; i < chunk_last; i++)
+					{
+						temp_vertex = all_vertices ? ip_get_vertex_by_location(i) : ip_get_vertex_by_id(ip_all_spread_vertices.data[i]);
+						ip_compute(temp_vertex);
+					}
+				}
+			}
+			else if(ip_is_first_superstep())
+			{
+				#pragma omp for schedule(runtime) nowait
+				for(size_t i = 0; i < ip_get_vertices_count(); i++)
+				{
+					ip_compute(ip_get_vertex_by_location(i));
+				}
+			}
+			else
+			{
+				#pragma omp for schedule(runtime) nowait
+				for(size_t i = 0; i < ip_all_spread_vertices.size; i++)
+				{
+					ip_compute(ip_get_vertex_by_id(ip_all_spread_vertices.data[i]));
+				}
+			}
+			// All vertices are computed, only the broadcasts deferred by hubs may be left to send.
+			ip_spin_barrier();
+
+			#ifdef IP_USE_HUB_BROADCASTS
+				//////////////////////////
+				// HUB BROADCAST PHASE //
+				////////////////////////
+				ip_run_hub_broadcasts();
+			#endif // ifdef IP_USE_HUB_BROADCASTS
+
+			#ifdef IP_USE_HUB_MAILBOXES
+				////////////////////////
+				// HUB MAILBOX PHASE //
+				//////////////////////
+				// Every hub gets the combination of the partial mailboxes that threads filled for it.
+				ip_combine_hub_mailboxes();
+			#endif // ifdef IP_USE_HUB_MAILBOXES
+
+			#ifdef IP_USE_PROPAGATION_BLOCKING
+				/////////////////////////
+				// BIN DELIVERY PHASE //
+				///////////////////////
+				ip_apply_bins();
+			#endif // ifdef IP_USE_PROPAGATION_BLOCKING
+
+			//////////////////////////////////////////////
+			// MAILBOX UPDATE AND SPREAD VERTICES MERGE //
+			////////////////////////////////////////////
+			// Every thread updates the mailboxes of the vertices in its own list while copying them right after those of the threads before it.
+			size_t my_offset = 0;
+			size_t spread_vertices_count = 0;
+			for(int i = 0; i < ip_thread_count; i++)
+			{
+				if(i < ip_my_thread_num)
+				{
+					my_offset += ip_all_thread_contexts[i].spread_vertices.size;
+				}
+				spread_vertices_count += ip_all_thread_contexts[i].spread_vertices.size;
+			}
+			IP_VERTEX_ID_TYPE spread_vertex_id;
+			for(size_t i = 0; i < my_list->size; i++)
+			{
+				spread_vertex_id = my_list->data[i];
+				temp_vertex = ip_get_vertex_by_id(spread_vertex_id);
+				temp_vertex->has_message = true;
+				temp_vertex->message = ip_all_externalised_structures[spread_vertex_id].message_next;
+				ip_empty_mailbox(&ip_all_externalised_structures[spread_vertex_id].has_message_next, &ip_all_externalised_structures[spread_vertex_id].message_next);
+				ip_all_spread_vertices.data[my_offset + i] = spread_vertex_id;
+			}
+			#ifdef IP_NEEDS_REMOTE_VALUES
+				ip_commit_values();
+			#endif // ifdef IP_NEEDS_REMOTE_VALUES
+			// Nobody runs ip_compute until the barrier below, so the master thread can already close the superstep.
+			if(ip_my_thread_num == 0)
+			{
+				ip_active_vertices = spread_vertices_count;
+				ip_all_spread_vertices.size = spread_vertices_count;
+				ip_reduce_aggregators();
+				ip_increment_superstep();
+			}
+			ip_spin_barrier();
+			// Other threads read the size of this list until the barrier above.
+			my_list->size = 0;
+
+			if(ip_my_thread_num == 0)
+			{
+				timer_superstep_stop = omp_get_wtime();
+				timer_superstep_total += (timer_superstep_stop - timer_superstep_start);
+				printf("Superstep%zuDuration:%f\n", ip_get_superstep() - 1, timer_superstep_stop - timer_superstep_start);
+				printf("Superstep%zuActiveVertexCount:%zu\n", ip_get_superstep() - 1, ip_active_vertices);
+				// The printing above is not part of the next superstep.
+				timer_superstep_start = omp_get_wtime();
+			}
+		} // End of superstep processing loop
+	} // End of OpenMP region
+
+	printf("Total time of supersteps: %fs.\n", timer_superstep_total);
+
+	// Free and clean program.
 	#pragma omp parallel
 	{
-		#pragma omp master
+		ip_safe_free(ip_all_thread_contexts[omp_get_thread_num()].spread_vertices.data);
+	}
+	ip_safe_free(ip_all_spread_vertices.data);
+
+	free(ip_all_externalised_structures);
+	#ifdef IP_USE_HUB_BROADCASTS
+		ip_free_hub_broadcasts();
+	#endif // ifdef IP_USE_HUB_BROADCASTS
+	#ifdef IP_USE_HUB_MAILBOXES
+		ip_free_hub_mailboxes();
+	#endif // ifdef IP_USE_HUB_MAILBOXES
+
+	return 0;
+}
+#else // ifndef IP_USE_SPIN_BARRIER
+#ifdef IP_USE_ADAPTIVE_THREADS
+	int ip_get_superstep_thread_count()
+	{
+		return ip_superstep_thread_count;
+	}
+
+	void ip_select_thread_count()
+	{
+		size_t edges_count = 0;
+		for(int i = 0; i < ip_thread_count; i++)
+		{
+			edges_count += ip_all_thread_contexts[i].spread_edges_count;
+			ip_all_thread_contexts[i].spread_edges_count = 0;
+		}
+		size_t work = ip_all_spread_vertices.size + edges_count;
+		size_t thread_count = (work + IP_ADAPTIVE_WORK_PER_THREAD - 1) / IP_ADAPTIVE_WORK_PER_THREAD;
+		if(ip_is_first_superstep() || thread_count > (size_t)ip_thread_count)
+		{
+			ip_superstep_thread_count = ip_thread_count;
+		}
+		else if(thread_count == 0)
+		{
+			ip_superstep_thread_count = 1;
+		}
+		else
+		{
+			ip_superstep_thread_count = thread_count;
+		}
+	}
+
+	double ip_run_sequential_supersteps()
+	{
+		double timer_total = 0;
+		struct ip_thread_context_t* my_context = &ip_all_thread_contexts[ip_my_thread_num];
+		while(!ip_is_first_superstep() && ip_all_spread_vertices.size > 0 && ip_superstep_thread_count == 1)
 		{
-			ip_all_spread_vertices_omp = (struct ip_vertex_list_t*)ip_safe_malloc(sizeof(struct ip_vertex_list_t) * ip_thread_count * IP_CACHE_LINE_LENGTH);
+			double timer_start = omp_get_wtime();
+			for(size_t i = 0; i < ip_all_spread_vertices.size; i++)
+			{
+				ip_compute(ip_get_vertex_by_id(ip_all_spread_vertices.data[i]));
+			}
+			#ifdef IP_USE_HUB_BROADCASTS
+				ip_run_hub_broadcasts_alone();
+			#endif // ifdef IP_USE_HUB_BROADCASTS
+			#ifdef IP_USE_HUB_MAILBOXES
+				ip_combine_hub_mailboxes_alone();
+			#endif // ifdef IP_USE_HUB_MAILBOXES
+			#ifdef IP_USE_PROPAGATION_BLOCKING
+				// ip_apply_bins() is a worksharing construct, only the bins of this thread hold messages anyway.
+				for(size_t i = 0; i < ip_bins_per_thread; i++)
+				{
+					struct ip_bin_t* bin = &ip_all_bins[ip_my_thread_num * ip_bins_per_thread + i];
+					for(size_t j = 0; j < bin->size; j++)
+					{
+						ip_deliver_binned_message(bin->data[j].id, bin->data[j].message);
+					}
+					bin->size = 0;
+				}
+			#endif // ifdef IP_USE_PROPAGATION_BLOCKING
+			#ifdef IP_NEEDS_REMOTE_VALUES
+				// Only the vertices executed may have changed their value, ip_commit_values() would copy them all.
+				for(size_t i = 0; i < ip_all_spread_vertices.size; i++)
+				{
+					struct ip_vertex_t* v = ip_get_vertex_by_id(ip_all_spread_vertices.data[i]);
+					ip_committed_values[v - ip_get_vertex_by_location(0)] = v->value;
+				}
+			#endif // ifdef IP_NEEDS_REMOTE_VALUES
+
+			// The list of this thread holds all the vertices to execute next superstep, it becomes the merged list and the other way round.
+			struct ip_vertex_list_t executed_vertices = ip_all_spread_vertices;
+			ip_all_spread_vertices = my_context->spread_vertices;
+			my_context->spread_vertices = executed_vertices;
+			my_context->spread_vertices.size = 0;
+			IP_VERTEX_ID_TYPE spread_vertex_id;
+			struct ip_vertex_t* temp_vertex = NULL;
+			for(size_t i = 0; i < ip_all_spread_vertices.size; i++)
+			{
+				spread_vertex_id = ip_all_spread_vertices.data[i];
+				temp_vertex = ip_get_vertex_by_id(spread_vertex_id);
+				temp_vertex->has_message = true;
+				temp_vertex->message = ip_all_externalised_structures[spread_vertex_id].message_next;
+				ip_empty_mailbox(&ip_all_externalised_structures[spread_vertex_id].has_message_next, &ip_all_externalised_structures[spread_vertex_id].message_next);
+				my_context->spread_edges_count += temp_vertex->out_neighbour_count;
+			}
+			ip_active_vertices = ip_all_spread_vertices.size;
+
+			double timer_stop = omp_get_wtime();
+			timer_total += timer_stop - timer_start;
+			printf("Superstep%zuDuration:%f\n", ip_get_superstep(), timer_stop - timer_start);
+			printf("Superstep%zuActiveVertexCount:%zu\n", ip_get_superstep(), ip_active_vertices);
+			printf("Superstep%zuThreadCount:1\n", ip_get_superstep());
+			ip_reduce_aggregators();
+			ip_increment_superstep();
+			ip_select_thread_count();
 		}
+		return timer_total;
 	}
+#endif // ifdef IP_USE_ADAPTIVE_THREADS
 
-	ip_all_spread_vertices.max_size = 1;
-	ip_all_spread_vertices.size = 0;
-	ip_all_spread_vertices.data = ip_safe_malloc(sizeof(IP_VERTEX_ID_TYPE) * ip_all_spread_vertices.max_size);
-	#pragma omp parallel default(none) shared(ip_all_spread_vertices_omp)
+#ifdef IP_USE_SORTED_FRONTIER
+	void ip_stop_compute_timer()
 	{
-		ip_all_spread_vertices_omp[omp_get_thread_num() * IP_CACHE_LINE_LENGTH].max_size = 1;
-		ip_all_spread_vertices_omp[omp_get_thread_num() * IP_CACHE_LINE_LENGTH].size = 0;
-		ip_all_spread_vertices_omp[omp_get_thread_num() * IP_CACHE_LINE_LENGTH].data = ip_safe_malloc(sizeof(IP_VERTEX_ID_TYPE) * ip_all_spread_vertices_omp[omp_get_thread_num() * IP_CACHE_LINE_LENGTH].max_size);
+		if(ip_my_thread_num == 0)
+		{
+			ip_timer_compute_stop = omp_get_wtime();
+		}
+	}
+
+	bool ip_merge_sorted_spread_vertices()
+	{
+		if(ip_active_vertices < ip_spread_bitmap_words_count)
+		{
+			return false;
+		}
+		double timer_start = omp_get_wtime();
+		struct ip_vertex_list_t* my_list = &ip_all_thread_contexts[ip_my_thread_num].spread_vertices;
+		struct ip_vertex_t* first_vertex = ip_get_vertex_by_location(0);
+		for(size_t i = 0; i < my_list->size; i++)
+		{
+			size_t location = ip_get_vertex_by_id(my_list->data[i]) - first_vertex;
+			atomic_fetch_or_explicit(&ip_spread_bitmap[location / 64], ((uint64_t)1) << (location % 64), memory_order_relaxed);
+		}
+		my_list->size = 0;
+		size_t first_word = ip_spread_bitmap_words_count * ip_my_thread_num / ip_thread_count;
+		size_t last_word = ip_spread_bitmap_words_count * (ip_my_thread_num + 1) / ip_thread_count;
+		// All vertices must be marked before any range is counted.
+		#pragma omp barrier
+		size_t my_count = 0;
+		for(size_t i = first_word; i < last_word; i++)
+		{
+			my_count += __builtin_popcountll(atomic_load_explicit(&ip_spread_bitmap[i], memory_order_relaxed));
+		}
+		ip_all_thread_contexts[ip_my_thread_num].sorted_spread_vertices_count = my_count;
+		// All ranges must be counted before any thread knows where to write.
+		#pragma omp barrier
+		size_t position = 0;
+		for(int i = 0; i < ip_my_thread_num; i++)
+		{
+			position += ip_all_thread_contexts[i].sorted_spread_vertices_count;
+		}
+		for(size_t i = first_word; i < last_word; i++)
+		{
+			uint64_t bits = atomic_load_explicit(&ip_spread_bitmap[i], memory_order_relaxed);
+			if(bits != 0)
+			{
+				// Only this thread reads this word, it is cleared for next superstep.
+				atomic_store_explicit(&ip_spread_bitmap[i], 0, memory_order_relaxed);
+				while(bits != 0)
+				{
+					size_t location = i * 64 + __builtin_ctzll(bits);
+					bits &= bits - 1;
+					ip_all_spread_vertices.data[position] = ip_get_vertex_by_location(location)->id;
+					position++;
+				}
+			}
+		}
+		if(ip_my_thread_num == 0)
+		{
+			ip_timer_sort_duration = omp_get_wtime() - timer_start;
+			ip_timer_sort_total += ip_timer_sort_duration;
+		}
+		return true;
+	}
+
+	void ip_print_sorted_frontier_timers(double timer_superstep_start)
+	{
+		printf("Superstep%zuComputeDuration:%f\n", ip_get_superstep(), ip_timer_compute_stop - timer_superstep_start);
+		printf("Superstep%zuSortDuration:%f\n", ip_get_superstep(), ip_timer_sort_duration);
+		ip_timer_sort_duration = 0;
+	}
+#endif // ifdef IP_USE_SORTED_FRONTIER
+
+#ifdef IP_USE_DENSE_FRONTIER
+	bool ip_is_frontier_dense()
+	{
+		return ip_dense_frontier_current;
+	}
+
+	void ip_compute_dense_frontier_word(size_t word_index, uint64_t bits)
+	{
+		while(bits != 0)
+		{
+			size_t location = word_index * 64 + __builtin_ctzll(bits);
+			bits &= bits - 1;
+			ip_compute(ip_get_vertex_by_location(location));
+		}
+	}
+
+	void ip_compute_dense_frontier()
+	{
+		_Atomic uint64_t* frontier = ip_dense_frontiers[ip_get_superstep() % 2];
+		if(ip_use_edge_stealing)
+		{
+			size_t chunk_first;
+			size_t chunk_last;
+			ip_prepare_chunks(NULL, ip_get_vertices_count());
+			while(ip_get_next_chunk(&chunk_first, &chunk_last))
+			{
+				for(size_t i = chunk_first / 64; chunk_first < chunk_last && i <= (chunk_last - 1) / 64; i++)
+				{
+					// Chunks are not aligned on words, so only the bits of this chunk are taken from the word.
+					uint64_t mask = UINT64_MAX;
+					if(i == chunk_first / 64)
+					{
+						mask &= UINT64_MAX << (chunk_first % 64);
+					}
+					if(i == (chunk_last - 1) / 64 && chunk_last % 64 != 0)
+					{
+						mask &= UINT64_MAX >> (64 - chunk_last % 64);
+					}
+					uint64_t bits = atomic_load_explicit(&frontier[i], memory_order_relaxed) & mask;
+					if(bits != 0)
+					{
+						atomic_fetch_and_explicit(&frontier[i], ~bits, memory_order_relaxed);
+						ip_compute_dense_frontier_word(i, bits);
+					}
+				}
+			}
+			// Replaces the implicit barrier of the OpenMP for below.
+			#pragma omp barrier
+		}
+		else
+		{
+			#pragma omp for schedule(runtime)
+			for(size_t i = 0; i < ip_dense_frontier_words_count; i++)
+			{
+				uint64_t bits = atomic_load_explicit(&frontier[i], memory_order_relaxed);
+				if(bits != 0)
+				{
+					// Nobody else writes the bitmap of the current superstep, it is cleared to become the bitmap of superstep after next.
+					atomic_store_explicit(&frontier[i], 0, memory_order_relaxed);
+					ip_compute_dense_frontier_word(i, bits);
+				}
+			}
+		}
+	}
+
+	bool ip_merge_dense_frontier()
+	{
+		size_t spread_vertices_count = 0;
+		for(int i = 0; i < ip_thread_count; i++)
+		{
+			spread_vertices_count += ip_all_thread_contexts[i].spread_vertices.size + ip_all_thread_contexts[i].dense_spread_vertices_count;
+		}
+		if(!ip_dense_frontier_next && spread_vertices_count * IP_DENSE_FRONTIER_RATIO < ip_get_vertices_count())
+		{
+			return false;
+		}
+
+		// A frontier recorded in lists that turns out dense is moved into the bitmap.
+		_Atomic uint64_t* frontier = ip_dense_frontiers[(ip_get_superstep() + 1) % 2];
+		struct ip_vertex_list_t* my_list = &ip_all_thread_contexts[ip_my_thread_num].spread_vertices;
+		struct ip_vertex_t* first_vertex = ip_get_vertex_by_location(0);
+		for(size_t i = 0; i < my_list->size; i++)
+		{
+			size_t location = ip_get_vertex_by_id(my_list->data[i]) - first_vertex;
+			atomic_fetch_or_explicit(&frontier[location / 64], ((uint64_t)1) << (location % 64), memory_order_relaxed);
+		}
+		// All threads must be done reading the counts and marking vertices.
+		#pragma omp barrier
+		my_list->size = 0;
+		ip_all_thread_contexts[ip_my_thread_num].dense_spread_vertices_count = 0;
+		if(ip_my_thread_num == 0)
+		{
+			ip_active_vertices = spread_vertices_count;
+		}
+
+		#pragma omp for schedule(runtime)
+		for(size_t i = 0; i < ip_dense_frontier_words_count; i++)
+		{
+			uint64_t bits = atomic_load_explicit(&frontier[i], memory_order_relaxed);
+			while(bits != 0)
+			{
+				struct ip_vertex_t* temp_vertex = ip_get_vertex_by_location(i * 64 + __builtin_ctzll(bits));
+				bits &= bits - 1;
+				temp_vertex->has_message = true;
+				temp_vertex->message = ip_all_externalised_structures[temp_vertex->id].message_next;
+				ip_empty_mailbox(&ip_all_externalised_structures[temp_vertex->id].has_message_next, &ip_all_externalised_structures[temp_vertex->id].message_next);
+			}
+		}
+		return true;
 	}
-	ip_all_externalised_structures = (struct ip_externalised_structure_t*)ip_safe_malloc(sizeof(struct ip_externalised_structure_t) * ip_get_vertices_count());
-}
+
+	void ip_select_frontier_representation(bool dense)
+	{
+		ip_dense_frontier_current = dense;
+		ip_dense_frontier_next = ip_active_vertices * IP_DENSE_FRONTIER_RATIO >= ip_get_vertices_count();
+	}
+#endif // ifdef IP_USE_DENSE_FRONTIER
 
 int ip_run()
 {
@@ -164,43 +634,25 @@ int ip_run()
 	double timer_superstep_stop = 0;
 
 	#ifdef IP_ENABLE_THREAD_PROFILING
-		double* timer_compute_start = malloc(sizeof(double) * ip_thread_count);
-		double* timer_compute_stop = malloc(sizeof(double) * ip_thread_count);
-		double* timer_compute_total = malloc(sizeof(double) * ip_thread_count);
-		double* timer_spread_merge_start = malloc(sizeof(double) * ip_thread_count);
-		double* timer_spread_merge_stop = malloc(sizeof(double) * ip_thread_count);
-		double* timer_spread_merge_total = malloc(sizeof(double) * ip_thread_count);
-		double* timer_mailbox_update_start = malloc(sizeof(double) * ip_thread_count);
-		double* timer_mailbox_update_stop = malloc(sizeof(double) * ip_thread_count);
-		double* timer_mailbox_update_total = malloc(sizeof(double) * ip_thread_count);
-		size_t* timer_edge_count = malloc(sizeof(size_t) * ip_thread_count);
 		size_t timer_edge_count_total = 0;
 	#endif
 
 	#ifdef IP_ENABLE_THREAD_PROFILING
-		#pragma omp parallel default(none) shared(ip_active_vertices, \
+		#pragma omp parallel default(none) shared(ip_all_thread_contexts, \
+												  ip_active_vertices, \
+												  ip_use_edge_stealing, \
 												  ip_all_spread_vertices, \
-												  ip_all_spread_vertices_omp, \
 												  ip_thread_count, \
 												  ip_all_externalised_structures, \
-												  timer_compute_start, \
-												  timer_compute_stop, \
-												  timer_compute_total, \
-												  timer_spread_merge_start, \
-												  timer_spread_merge_stop, \
-												  timer_spread_merge_total, \
-												  timer_mailbox_update_start, \
-												  timer_mailbox_update_stop, \
-												  timer_mailbox_update_total, \
-												  timer_edge_count, \
 												  timer_edge_count_total, \
 												  timer_superstep_total, \
 												  timer_superstep_start, \
 												  timer_superstep_stop)
 	#else
-		#pragma omp parallel default(none) shared(ip_active_vertices, \
+		#pragma omp parallel default(none) shared(ip_all_thread_contexts, \
+												  ip_active_vertices, \
+												  ip_use_edge_stealing, \
 												  ip_all_spread_vertices, \
-												  ip_all_spread_vertices_omp, \
 												  ip_thread_count, \
 												  ip_all_externalised_structures, \
 												  timer_superstep_total, \
@@ -220,19 +672,86 @@ int ip_run()
 			// This OpenMP single also acts as an implicit barrier to wait for all threads before they start processing a superstep.
 			#pragma omp single
 			{
+				#ifdef IP_USE_ADAPTIVE_THREADS
+					ip_select_thread_count();
+					timer_superstep_total += ip_run_sequential_supersteps();
+				#endif // ifdef IP_USE_ADAPTIVE_THREADS
 				ip_active_vertices = 0;
 				timer_superstep_start = omp_get_wtime();
 			}
+			#ifdef IP_USE_ADAPTIVE_THREADS
+				// The sequential supersteps may have run out of vertices to execute.
+				if(!ip_is_first_superstep() && ip_all_spread_vertices.size == 0)
+				{
+					break;
+				}
+			#endif // ifdef IP_USE_ADAPTIVE_THREADS
 			
 			////////////////////
 			// COMPUTE PHASE //
 			//////////////////
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_compute_start[ip_my_thread_num] = omp_get_wtime();
-				timer_edge_count[ip_my_thread_num] = 0;
+				ip_all_thread_contexts[ip_my_thread_num].timer_compute_start = omp_get_wtime();
+				ip_all_thread_contexts[ip_my_thread_num].timer_edge_count = 0;
 			#endif
 			struct ip_vertex_t* temp_vertex = NULL;
-			if(ip_is_first_superstep())
+			#ifdef IP_USE_DENSE_FRONTIER
+				if(ip_is_frontier_dense())
+				{
+					ip_compute_dense_frontier();
+				}
+				else
+			#endif // ifdef IP_USE_DENSE_FRONTIER
+			#ifdef IP_USE_ADAPTIVE_THREADS
+				// Checked before edge stealing, whose chunks are shared between all threads of the team.
+				if(ip_get_superstep_thread_count() < ip_thread_count)
+				{
+					// Only the first threads take part, each executing a contiguous slice of the vertices; the others go straight to the barrier.
+					int superstep_thread_count = ip_get_superstep_thread_count();
+					if(ip_my_thread_num < superstep_thread_count)
+					{
+						size_t slice_first = ip_all_spread_vertices.size * ip_my_thread_num / superstep_thread_count;
+						size_t slice_last = ip_all_spread_vertices.size * (ip_my_thread_num + 1) / superstep_thread_count;
+						for(size_t i = slice_first; i < slice_last; i++)
+						{
+							ip_compute(ip_get_vertex_by_id(ip_all_spread_vertices.data[i]));
+						}
+					}
+					// Replaces the implicit barrier of the OpenMP for below.
+					#pragma omp barrier
+				}
+				else
+			#endif // ifdef IP_USE_ADAPTIVE_THREADS
+			if(ip_use_edge_stealing)
+			{
+				bool all_vertices = ip_is_first_superstep();
+				size_t chunk_first;
+				size_t chunk_last;
+				#ifdef IP_ENABLE_THREAD_PROFILING
+					size_t my_edge_count_total = 0;
+				#endif
+				ip_prepare_chunks(all_vertices ? NULL : ip_all_spread_vertices.data, all_vertices ? ip_get_vertices_count() : ip_all_spread_vertices.size);
+				while(ip_get_next_chunk(&chunk_first, &chunk_last))
+				{
+					for(size_t i = chunk_first; i < chunk_last; i++)
+					{
+						temp_vertex = all_vertices ? ip_get_vertex_by_location(i) : ip_get_vertex_by_id(ip_all_spread_vertices.data[i]);
+						ip_compute(temp_vertex);
+						#ifdef IP_ENABLE_THREAD_PROFILING
+							ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop = omp_get_wtime();
+							ip_all_thread_contexts[ip_my_thread_num].timer_edge_count += temp_vertex->out_neighbour_count;
+							my_edge_count_total += temp_vertex->out_neighbour_count;
+						#endif
+					}
+				}
+				#ifdef IP_ENABLE_THREAD_PROFILING
+					#pragma omp atomic
+					timer_edge_count_total += my_edge_count_total;
+				#endif
+				// Replaces the implicit barrier of the OpenMP for below.
+				#pragma omp barrier
+			}
+			else if(ip_is_first_superstep())
 			{
 				#ifdef IP_ENABLE_THREAD_PROFILING
 					#pragma omp for reduction(+:timer_edge_count_total) schedule(runtime)
@@ -244,8 +763,8 @@ int ip_run()
 					temp_vertex = ip_get_vertex_by_location(i);
 					ip_compute(temp_vertex);
 					#ifdef IP_ENABLE_THREAD_PROFILING
-						timer_compute_stop[ip_my_thread_num] = omp_get_wtime();
-						timer_edge_count[ip_my_thread_num] += temp_vertex->out_neighbour_count;
+						ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop = omp_get_wtime();
+						ip_all_thread_contexts[ip_my_thread_num].timer_edge_count += temp_vertex->out_neighbour_count;
 						timer_edge_count_total += temp_vertex->out_neighbour_count;
 					#endif
 				}
@@ -264,92 +783,149 @@ int ip_run()
 					temp_vertex = ip_get_vertex_by_id(spread_neighbour_id);
 					ip_compute(temp_vertex);
 					#ifdef IP_ENABLE_THREAD_PROFILING
-						timer_compute_stop[ip_my_thread_num] = omp_get_wtime();
-						timer_edge_count[ip_my_thread_num] += temp_vertex->out_neighbour_count;
+						ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop = omp_get_wtime();
+						ip_all_thread_contexts[ip_my_thread_num].timer_edge_count += temp_vertex->out_neighbour_count;
 						timer_edge_count_total += temp_vertex->out_neighbour_count;
 					#endif
 				}
 			}
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_compute_total[ip_my_thread_num] = timer_compute_stop[ip_my_thread_num] - timer_compute_start[ip_my_thread_num];
+				ip_all_thread_contexts[ip_my_thread_num].timer_compute_total = ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop - ip_all_thread_contexts[ip_my_thread_num].timer_compute_start;
 			#endif
+			#ifdef IP_USE_SORTED_FRONTIER
+				ip_stop_compute_timer();
+			#endif // ifdef IP_USE_SORTED_FRONTIER
 			
-			////////////////////////////
-			// ACTIVE VERTICES COUNT //
-			//////////////////////////
+			#ifdef IP_USE_HUB_BROADCASTS
+				//////////////////////////
+				// HUB BROADCAST PHASE //
+				////////////////////////
+				ip_run_hub_broadcasts();
+			#endif // ifdef IP_USE_HUB_BROADCASTS
+
+			#ifdef IP_USE_HUB_MAILBOXES
+				////////////////////////
+				// HUB MAILBOX PHASE //
+				//////////////////////
+				// Every hub gets the combination of the partial mailboxes that threads filled for it.
+				ip_combine_hub_mailboxes();
+			#endif // ifdef IP_USE_HUB_MAILBOXES
+
+			#ifdef IP_USE_PROPAGATION_BLOCKING
+				/////////////////////////
+				// BIN DELIVERY PHASE //
+				///////////////////////
+				// Deliver the messages binned during the compute phase; the first delivery into a mailbox flags the vertex for next superstep.
+				ip_apply_bins();
+			#endif // ifdef IP_USE_PROPAGATION_BLOCKING
 
-			#pragma omp atomic
-			ip_active_vertices += ip_all_spread_vertices_omp[ip_my_thread_num * IP_CACHE_LINE_LENGTH].size;
-
-			// This barrier is crucial; it makes sure that no thread can enter the single below, which uses ip_active_vertices, before every thread incremented it ip_active_vertices with their own value.
-			#pragma omp barrier
 			
-			//////////////////////////////////
-			// SPREAD VERTICES MERGE PHASE //
-			////////////////////////////////
-			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_spread_merge_start[ip_my_thread_num] = omp_get_wtime();
-				timer_spread_merge_stop[ip_my_thread_num] = timer_spread_merge_start[ip_my_thread_num];
-			#endif
-			#pragma omp single
+			#ifdef IP_USE_DENSE_FRONTIER
+				/////////////////////////////////
+				// DENSE FRONTIER MERGE PHASE //
+				///////////////////////////////
+				// When the vertices to execute next superstep are numerous, they stay in a bitmap which the mailbox update goes through.
+				bool dense = ip_merge_dense_frontier();
+			#else
+				bool dense = false;
+			#endif // ifdef IP_USE_DENSE_FRONTIER
+			if(!dense)
 			{
-				if(ip_all_spread_vertices.max_size < ip_active_vertices)
+				//////////////////////////////////
+				// SPREAD VERTICES MERGE PHASE //
+				////////////////////////////////
+				#ifdef IP_ENABLE_THREAD_PROFILING
+					ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_start = omp_get_wtime();
+					ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_stop = ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_start;
+				#endif
+				// Every thread copies its own list right after those of the threads before it.
+				struct ip_vertex_list_t* my_list = &ip_all_thread_contexts[ip_my_thread_num].spread_vertices;
+				size_t my_offset = 0;
+				for(int i = 0; i < ip_my_thread_num; i++)
 				{
-					ip_all_spread_vertices.data = ip_safe_realloc(ip_all_spread_vertices.data, sizeof(IP_VERTEX_ID_TYPE) * ip_active_vertices);
-					ip_all_spread_vertices.max_size = ip_active_vertices;
+					my_offset += ip_all_thread_contexts[i].spread_vertices.size;
 				}
-			
-				ip_all_spread_vertices.size = 0;
-	
-				for(int i = 0; i < ip_thread_count; i++)
+				#pragma omp single
 				{
-					if(ip_all_spread_vertices_omp[i * IP_CACHE_LINE_LENGTH].size > 0)
+					// The barrier ending the phase above guarantees that all threads are done filling their lists.
+					for(int i = 0; i < ip_thread_count; i++)
+					{
+						ip_active_vertices += ip_all_thread_contexts[i].spread_vertices.size;
+					}
+					if(ip_all_spread_vertices.max_size < ip_active_vertices)
 					{
-						memmove(&ip_all_spread_vertices.data[ip_all_spread_vertices.size], ip_all_spread_vertices_omp[i * IP_CACHE_LINE_LENGTH].data, ip_all_spread_vertices_omp[i * IP_CACHE_LINE_LENGTH].size * sizeof(IP_VERTEX_ID_TYPE));
-						ip_all_spread_vertices.size += ip_all_spread_vertices_omp[i * IP_CACHE_LINE_LENGTH].size;
-						ip_all_spread_vertices_omp[i * IP_CACHE_LINE_LENGTH].size = 0;
+						ip_all_spread_vertices.data = ip_safe_realloc(ip_all_spread_vertices.data, sizeof(IP_VERTEX_ID_TYPE) * ip_active_vertices);
+						ip_all_spread_vertices.max_size = ip_active_vertices;
 					}
+					ip_all_spread_vertices.size = ip_active_vertices;
+				}
+				#ifdef IP_USE_SORTED_FRONTIER
+					bool sorted = ip_merge_sorted_spread_vertices();
+				#else
+					bool sorted = false;
+				#endif // ifdef IP_USE_SORTED_FRONTIER
+				if(!sorted && my_list->size > 0)
+				{
+					memcpy(&ip_all_spread_vertices.data[my_offset], my_list->data, my_list->size * sizeof(IP_VERTEX_ID_TYPE));
+					my_list->size = 0;
 				}
 				#ifdef IP_ENABLE_THREAD_PROFILING
-					timer_spread_merge_stop[ip_my_thread_num] = omp_get_wtime();
+					ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_stop = omp_get_wtime();
+				#endif
+				// The vertices to execute are read by all threads from now on.
+				#pragma omp barrier
+				#ifdef IP_ENABLE_THREAD_PROFILING
+					ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_total = ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_stop - ip_all_thread_contexts[ip_my_thread_num].timer_spread_merge_start;
 				#endif
-			}
-			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_spread_merge_total[ip_my_thread_num] = timer_spread_merge_stop[ip_my_thread_num] - timer_spread_merge_start[ip_my_thread_num];
-			#endif
 
-			///////////////////////////
-			// MAILBOX UPDATE PHASE //
-			/////////////////////////
-			// Take in account only the vertices that have been flagged as
-			// spread -> that is, vertices having received a new message.
-			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_mailbox_update_start[ip_my_thread_num] = omp_get_wtime();
-				timer_mailbox_update_stop[ip_my_thread_num] = timer_mailbox_update_start[ip_my_thread_num];
-			#endif
-			IP_VERTEX_ID_TYPE spread_vertex_id;
-			#pragma omp for schedule(runtime)
-			for(size_t i = 0; i < ip_all_spread_vertices.size; i++)
-			{
-				spread_vertex_id = ip_all_spread_vertices.data[i];
-				temp_vertex = ip_get_vertex_by_id(spread_vertex_id);
-				temp_vertex->has_message = true;
-				temp_vertex->message = ip_all_externalised_structures[spread_vertex_id].message_next;
-				ip_all_externalised_structures[spread_vertex_id].has_message_next = false;
+				///////////////////////////
+				// MAILBOX UPDATE PHASE //
+				/////////////////////////
+				// Take in account only the vertices that have been flagged as
+				// spread -> that is, vertices having received a new message.
+				#ifdef IP_ENABLE_THREAD_PROFILING
+					ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_start = omp_get_wtime();
+					ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_stop = ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_start;
+				#endif
+				IP_VERTEX_ID_TYPE spread_vertex_id;
+				#pragma omp for schedule(runtime)
+				for(size_t i = 0; i < ip_all_spread_vertices.size; i++)
+				{
+					spread_vertex_id = ip_all_spread_vertices.data[i];
+					temp_vertex = ip_get_vertex_by_id(spread_vertex_id);
+					temp_vertex->has_message = true;
+					temp_vertex->message = ip_all_externalised_structures[spread_vertex_id].message_next;
+					ip_empty_mailbox(&ip_all_externalised_structures[spread_vertex_id].has_message_next, &ip_all_externalised_structures[spread_vertex_id].message_next);
+					#ifdef IP_USE_ADAPTIVE_THREADS
+						ip_all_thread_contexts[ip_my_thread_num].spread_edges_count += temp_vertex->out_neighbour_count;
+					#endif // ifdef IP_USE_ADAPTIVE_THREADS
+					#ifdef IP_ENABLE_THREAD_PROFILING
+						ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_stop = omp_get_wtime();
+					#endif
+				}
 				#ifdef IP_ENABLE_THREAD_PROFILING
-					timer_mailbox_update_stop[ip_my_thread_num] = omp_get_wtime();
+					ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_total = ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_stop - ip_all_thread_contexts[ip_my_thread_num].timer_mailbox_update_start;
 				#endif
 			}
-			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_mailbox_update_total[ip_my_thread_num] = timer_mailbox_update_stop[ip_my_thread_num] - timer_mailbox_update_start[ip_my_thread_num];
-			#endif
-		
+
+			#ifdef IP_NEEDS_REMOTE_VALUES
+				ip_commit_values();
+			#endif // ifdef IP_NEEDS_REMOTE_VALUES
 			#pragma omp single
 			{
 				timer_superstep_stop = omp_get_wtime();
 				timer_superstep_total += (timer_superstep_stop - timer_superstep_start);
 				printf("Superstep%zuDuration:%f\n", ip_get_superstep(), timer_superstep_stop - timer_superstep_start);
 				printf("Superstep%zuActiveVertexCount:%zu\n", ip_get_superstep(), ip_active_vertices);
+				#ifdef IP_USE_ADAPTIVE_THREADS
+					printf("Superstep%zuThreadCount:%d\n", ip_get_superstep(), ip_get_superstep_thread_count());
+				#endif // ifdef IP_USE_ADAPTIVE_THREADS
+				#ifdef IP_USE_SORTED_FRONTIER
+					ip_print_sorted_frontier_timers(timer_superstep_start);
+				#endif // ifdef IP_USE_SORTED_FRONTIER
+				#ifdef IP_USE_DENSE_FRONTIER
+					ip_select_frontier_representation(dense);
+				#endif // ifdef IP_USE_DENSE_FRONTIER
 				#ifdef IP_ENABLE_THREAD_PROFILING
 					printf("            +");
 					for(int i = 0; i < ip_thread_count; i++)
@@ -369,27 +945,27 @@ int ip_run()
 					printf("\n|   Compute |");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf(" %8.3fs |", timer_compute_total[i]);
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_compute_total);
 					}
 					printf("\n|   Merging |");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf(" %8.3fs |", timer_spread_merge_total[i]);
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_spread_merge_total);
 					}
 					printf("\n|   Mailbox |");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf(" %8.3fs |", timer_mailbox_update_total[i]);
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_mailbox_update_total);
 					}
 					printf("\n|     Total |");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf(" %8.3fs |", timer_compute_total[i] + timer_spread_merge_total[i] + timer_mailbox_update_total[i]);
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_compute_total + ip_all_thread_contexts[i].timer_spread_merge_total + ip_all_thread_contexts[i].timer_mailbox_update_total);
 					}
 					printf("\n| EdgeCount |");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf(" %8.3f%% |", 100.0 * (((double)timer_edge_count[i]) / ((double)timer_edge_count_total)));
+						printf(" %8.3f%% |", 100.0 * (((double)ip_all_thread_contexts[i].timer_edge_count) / ((double)timer_edge_count_total)));
 					}
 					printf("\n+-----------+");
 					for(int i = 0; i < ip_thread_count; i++)
@@ -399,57 +975,45 @@ int ip_run()
 					printf("\n");
 					timer_edge_count_total = 0;
 				#endif
+				ip_reduce_aggregators();
 				ip_increment_superstep();
  			} // End of OpenMP single region
 		} // End of superstep processing loop
  	} // End of OpenMP region
 
 	printf("Total time of supersteps: %fs.\n", timer_superstep_total);
+	#ifdef IP_USE_SORTED_FRONTIER
+		printf("Total time of frontier sorting: %fs.\n", ip_timer_sort_total);
+	#endif // ifdef IP_USE_SORTED_FRONTIER
 
 	// Free and clean program.	
 	#pragma omp parallel
 	{
-		ip_safe_free(ip_all_spread_vertices_omp[omp_get_thread_num() * IP_CACHE_LINE_LENGTH].data);
+		ip_safe_free(ip_all_thread_contexts[omp_get_thread_num()].spread_vertices.data);
 	}
 	ip_safe_free(ip_all_spread_vertices.data);
+	#ifdef IP_USE_SORTED_FRONTIER
+		ip_safe_free(ip_spread_bitmap);
+	#endif // ifdef IP_USE_SORTED_FRONTIER
+	#ifdef IP_USE_DENSE_FRONTIER
+		ip_safe_free(ip_dense_frontiers[0]);
+		ip_safe_free(ip_dense_frontiers[1]);
+	#endif // ifdef IP_USE_DENSE_FRONTIER
 
-	#ifdef IP_ENABLE_THREAD_PROFILING
-		free(timer_compute_start);
-		free(timer_compute_stop);
-		free(timer_compute_total);
-		free(timer_spread_merge_start);
-		free(timer_spread_merge_stop);
-		free(timer_spread_merge_total);
-		free(timer_mailbox_update_start);
-		free(timer_mailbox_update_stop);
-		free(timer_mailbox_update_total);
-		free(timer_edge_count);
-	#endif
 	free(ip_all_externalised_structures);
+	#ifdef IP_USE_HUB_BROADCASTS
+		ip_free_hub_broadcasts();
+	#endif // ifdef IP_USE_HUB_BROADCASTS
+	#ifdef IP_USE_HUB_MAILBOXES
+		ip_free_hub_mailboxes();
+	#endif // ifdef IP_USE_HUB_MAILBOXES
 
 	return 0;
 }
+#endif // ifdef IP_USE_SPIN_BARRIER
 
 void ip_vote_to_halt(struct ip_vertex_t* v)
 {
 	(void)(v);
 }
-
-void ip_lock_init(IP_LOCK_TYPE* lock)
-{
-	*lock = 0;
-}
-
-void ip_lock_acquire(IP_LOCK_TYPE* lock)
-{
-	int zero = 0;
-	while(!atomic_compare_exchange_strong(lock, &zero, 1))
-		zero = 0;
-}
-
-void ip_lock_release(IP_LOCK_TYPE* lock)
-{
-	atomic_store(lock, 0);
-}
-
 #endif // COMBINER_SPREAD_POSTAMBLE_H_INCLUDED
@@ -33,9 +33,27 @@
 	#define IP_NEEDS_OUT_NEIGHBOUR_COUNT
 #endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_COUNT
 
+#ifdef IP_USE_ADAPTIVE_THREADS
+	#ifndef IP_ADAPTIVE_WORK_PER_THREAD
+		/// The work of a superstep, counted as vertices to execute plus their out-edges, that justifies one more thread taking part in it.
+		#define IP_ADAPTIVE_WORK_PER_THREAD 4096
+	#endif // ifndef IP_ADAPTIVE_WORK_PER_THREAD
+#endif // ifdef IP_USE_ADAPTIVE_THREADS
+
+#if defined(IP_USE_SPIN_BARRIER) && defined(IP_ENABLE_THREAD_PROFILING)
+	#error The supersteps built around spinning barriers fuse the phases that thread profiling times separately, IP_USE_SPIN_BARRIER and IP_ENABLE_THREAD_PROFILING cannot be used together.
+#endif // if defined(IP_USE_SPIN_BARRIER) && defined(IP_ENABLE_THREAD_PROFILING)
+#if defined(IP_USE_DENSE_FRONTIER) && defined(IP_ENABLE_THREAD_PROFILING)
+	#error Thread profiling times the merge and mailbox update phases of list frontiers only, IP_USE_DENSE_FRONTIER and IP_ENABLE_THREAD_PROFILING cannot be used together.
+#endif // if defined(IP_USE_DENSE_FRONTIER) && defined(IP_ENABLE_THREAD_PROFILING)
+#ifdef IP_USE_DENSE_FRONTIER
+	#ifndef IP_DENSE_FRONTIER_RATIO
+		/// The frontier is held in a bitmap once it holds at least one vertex in IP_DENSE_FRONTIER_RATIO.
+		#define IP_DENSE_FRONTIER_RATIO 20
+	#endif // ifndef IP_DENSE_FRONTIER_RATIO
+#endif // ifdef IP_USE_DENSE_FRONTIER
+
 // Global variables
-/// The data type used to implement locks.
-typedef volatile atomic_int IP_LOCK_TYPE;	
 /// This structure holds a list of vertex identifiers.
 struct ip_vertex_list_t
 {
@@ -50,15 +68,51 @@ struct ip_vertex_list_t
 size_t ip_spread_vertices_count = 0;
 /// This contains all the vertices to execute next superstep.
 struct ip_vertex_list_t ip_all_spread_vertices;
-/// This contains the vertices that threads found to be executed next superstep.
-struct ip_vertex_list_t* ip_all_spread_vertices_omp = NULL;
+/// This structure holds the state private to each thread; each instance sits on its own cache lines to avoid false sharing.
+struct ip_thread_context_t
+{
+	/// The vertices this thread found to be executed next superstep.
+	_Alignas(IP_CACHE_LINE_SIZE) struct ip_vertex_list_t spread_vertices;
+	#ifdef IP_USE_ADAPTIVE_THREADS
+		/// The number of out-edges of the vertices whose mailbox this thread updated for next superstep.
+		size_t spread_edges_count;
+	#endif // ifdef IP_USE_ADAPTIVE_THREADS
+	#ifdef IP_USE_SORTED_FRONTIER
+		/// The number of vertices to execute next superstep that this thread found in its range of ip_spread_bitmap.
+		size_t sorted_spread_vertices_count;
+	#endif // ifdef IP_USE_SORTED_FRONTIER
+	#ifdef IP_USE_DENSE_FRONTIER
+		/// The number of vertices this thread set the bit of in the frontier of next superstep.
+		size_t dense_spread_vertices_count;
+	#endif // ifdef IP_USE_DENSE_FRONTIER
+	#ifdef IP_ENABLE_THREAD_PROFILING
+		/// The time at which this thread started the compute phase at current superstep.
+		double timer_compute_start;
+		/// The time at which this thread stopped the compute phase at current superstep.
+		double timer_compute_stop;
+		/// The time spent by this thread in the compute phase, accumulated over all supersteps.
+		double timer_compute_total;
+		/// The time at which this thread started the mailbox update phase at current superstep.
+		double timer_mailbox_update_start;
+		/// The time at which this thread stopped the mailbox update phase at current superstep.
+		double timer_mailbox_update_stop;
+		/// The time spent by this thread in the mailbox update phase, accumulated over all supersteps.
+		double timer_mailbox_update_total;
+		/// The time at which this thread started merging the spread vertices at current superstep.
+		double timer_spread_merge_start;
+		/// The time at which this thread stopped merging the spread vertices at current superstep.
+		double timer_spread_merge_stop;
+		/// The time spent by this thread in merging the spread vertices, accumulated over all supersteps.
+		double timer_spread_merge_total;
+		/// The number of out-edges processed by this thread at current superstep.
+		size_t timer_edge_count;
+	#endif // ifdef IP_ENABLE_THREAD_PROFILING
+};
 /// Contains active broadcast attributes
 struct ip_externalised_structure_t
 {
 	/// Indicates whether the vertex has received messages from current superstep so far
-	atomic_bool has_message_next;
-	/// The lock used for mailbox thread-safe accesses
-	IP_LOCK_TYPE lock;
+	IP_MAILBOX_FLAG_TYPE has_message_next;
 	/// Contains the combined message made from message received from current superstep so far
 	IP_MESSAGE_TYPE message_next;
 };
@@ -110,20 +164,133 @@ struct ip_vertex_t
  * @post The vertex identifier by \p id will be executed at next superstep.
  **/
 void ip_add_spread_vertex(IP_VERTEX_ID_TYPE id);
-/**
- * @brief This function initialises the lock \p lock.
- * @param[in] lock The lock to initialise.
- **/
-void ip_lock_init(IP_LOCK_TYPE* lock);
-/**
- * @brief This function acquires the lock \p lock.
- * @param[in] lock The lock to acquire.
- **/
-void ip_lock_acquire(IP_LOCK_TYPE* lock);
-/**
- * @brief This function releases the lock \p lock.
- * @param[in] lock The lock to release.
- **/
-void ip_lock_release(IP_LOCK_TYPE* lock);
+#ifdef IP_USE_ADAPTIVE_THREADS
+	/// The number of threads taking part in the current superstep.
+	int ip_superstep_thread_count = 0;
+	/**
+	 * @brief This function returns the number of threads taking part in the
+	 * current superstep.
+	 * @return The number of threads taking part in the current superstep.
+	 **/
+	int ip_get_superstep_thread_count();
+	/**
+	 * @brief This function picks the number of threads taking part in next
+	 * superstep from the amount of work it holds.
+	 * @details It gives a thread per IP_ADAPTIVE_WORK_PER_THREAD units of work,
+	 * the work being the number of vertices to execute plus their out-edges.
+	 * The first superstep executes all vertices and always takes all threads.
+	 * @pre The mailbox update phase is over.
+	 * @post The out-edges counted by all threads are reset.
+	 **/
+	void ip_select_thread_count();
+	/**
+	 * @brief This function executes, on the calling thread alone, the
+	 * supersteps that ip_select_thread_count() gives a single thread to.
+	 * @details No barrier is involved: the calling thread computes the vertices
+	 * to execute, delivers its bins if any, and its own list then holds all
+	 * the vertices to execute next superstep.
+	 * @return The time spent in the supersteps executed.
+	 * @pre The calling thread is the only one running.
+	 * @post Either there is no vertex left to execute, or next superstep takes
+	 * more than one thread.
+	 **/
+	double ip_run_sequential_supersteps();
+#endif // ifdef IP_USE_ADAPTIVE_THREADS
+#ifdef IP_USE_SORTED_FRONTIER
+	/// The number of 64-bit words in ip_spread_bitmap.
+	size_t ip_spread_bitmap_words_count = 0;
+	/// One bit per vertex location, through which the vertices to execute next superstep are put in increasing order.
+	_Atomic uint64_t* ip_spread_bitmap = NULL;
+	/// The time at which the master thread saw the compute phase of the current superstep end.
+	double ip_timer_compute_stop = 0;
+	/// The time the master thread spent sorting the vertices to execute next superstep.
+	double ip_timer_sort_duration = 0;
+	/// The time the master thread spent sorting, accumulated over all supersteps.
+	double ip_timer_sort_total = 0;
+	/**
+	 * @brief This function records the end of the compute phase of the current
+	 * superstep.
+	 * @pre The barrier ending the compute phase is passed.
+	 **/
+	void ip_stop_compute_timer();
+	/**
+	 * @brief This function merges the lists of all threads into
+	 * ip_all_spread_vertices in increasing order of location, so that the next
+	 * superstep goes through the vertices and their mailboxes in memory order.
+	 * @details Threads mark the vertices of their list in ip_spread_bitmap,
+	 * then every thread scans a contiguous range of words and writes the
+	 * vertices it finds after those found by the threads before it. Frontiers
+	 * holding fewer vertices than the bitmap has words are not worth the scan
+	 * and are left to the usual merge. This function contains OpenMP barriers
+	 * when it sorts and must therefore be called by all threads of the team.
+	 * @retval true The vertices are merged, all lists are empty.
+	 * @retval false The frontier is too sparse, nothing is done.
+	 * @pre ip_active_vertices holds the total size of the lists and
+	 * ip_all_spread_vertices can hold them all.
+	 **/
+	bool ip_merge_sorted_spread_vertices();
+	/**
+	 * @brief This function prints how long the compute phase and the sorting of
+	 * the current superstep took.
+	 * @param[in] timer_superstep_start The time at which the superstep started.
+	 * @post The sorting time is reset for the next superstep.
+	 **/
+	void ip_print_sorted_frontier_timers(double timer_superstep_start);
+#endif // ifdef IP_USE_SORTED_FRONTIER
+#ifdef IP_USE_DENSE_FRONTIER
+	/// The number of 64-bit words in a dense frontier.
+	size_t ip_dense_frontier_words_count = 0;
+	/// The vertices to execute as bitmaps indexed by location, one per superstep parity: the bitmap of the current superstep is read while the other one is filled for next superstep.
+	_Atomic uint64_t* ip_dense_frontiers[2] = {NULL, NULL};
+	/// Indicates whether the vertices to execute at the current superstep are in the bitmap rather than in ip_all_spread_vertices.
+	bool ip_dense_frontier_current = false;
+	/// Indicates whether the vertices to execute at next superstep are recorded in the bitmap rather than in the lists of threads.
+	bool ip_dense_frontier_next = true;
+	/**
+	 * @brief This function checks whether the vertices to execute at the
+	 * current superstep are held in a bitmap.
+	 * @retval true The vertices are in the bitmap of the current superstep.
+	 * @retval false The vertices are in ip_all_spread_vertices.
+	 **/
+	bool ip_is_frontier_dense();
+	/**
+	 * @brief This function executes the vertices whose bit is set in \p bits.
+	 * @param[in] word_index The index of the bitmap word \p bits comes from.
+	 * @param[in] bits The bits of the vertices to execute.
+	 **/
+	void ip_compute_dense_frontier_word(size_t word_index, uint64_t bits);
+	/**
+	 * @brief This function executes the vertices whose bit is set in the
+	 * bitmap of the current superstep, and clears that bitmap.
+	 * @details This function contains OpenMP constructs and must therefore be
+	 * called by all threads of the team.
+	 * @pre ip_is_frontier_dense() returns true.
+	 **/
+	void ip_compute_dense_frontier();
+	/**
+	 * @brief This function puts the vertices to execute at next superstep in
+	 * the bitmap of next superstep and updates their mailboxes, if there are
+	 * enough of them.
+	 * @details The vertices recorded in the lists of threads are moved into the
+	 * bitmap when they reach one vertex in IP_DENSE_FRONTIER_RATIO. This
+	 * function contains OpenMP constructs when it returns true and must
+	 * therefore be called by all threads of the team.
+	 * @retval true The frontier of next superstep is in its bitmap, the
+	 * mailboxes are updated and ip_active_vertices is set.
+	 * @retval false The frontier of next superstep is in the lists of threads,
+	 * to be merged as usual.
+	 * @pre All threads are done sending messages for the current superstep.
+	 **/
+	bool ip_merge_dense_frontier();
+	/**
+	 * @brief This function records how the frontier of next superstep is held
+	 * and picks how the one after is recorded.
+	 * @details The frontier after next superstep is predicted to be as dense as
+	 * that of next superstep.
+	 * @param[in] dense Whether the frontier of next superstep is in its bitmap.
+	 * @pre ip_active_vertices holds the size of the frontier of next superstep.
+	 **/
+	void ip_select_frontier_representation(bool dense);
+#endif // ifdef IP_USE_DENSE_FRONTIER
 
 #endif // COMBINER_SPREAD_PREAMBLE_H_INCLUDED
@@ -21,19 +21,85 @@
 #include <omp.h>
 #include <string.h>
 
-int ip_my_thread_num;
-#pragma omp threadprivate(ip_my_thread_num)
-
-void ip_add_target(IP_VERTEX_ID_TYPE id)
+void ip_add_target(struct ip_targets_t* targets, IP_VERTEX_ID_TYPE id)
 {
-	if(ip_all_targets.size == ip_all_targets.max_size)
+	if(targets->size == targets->max_size)
 	{
-		ip_all_targets.max_size++;
-		ip_all_targets.data = ip_safe_realloc(ip_all_targets.data, sizeof(IP_VERTEX_ID_TYPE) * ip_all_targets.max_size);
+		targets->max_size = targets->max_size == 0 ? 1 : targets->max_size * 2;
+		targets->data = ip_safe_realloc(targets->data, sizeof(IP_VERTEX_ID_TYPE) * targets->max_size);
 	}
 
-	ip_all_targets.data[ip_all_targets.size] = id;
-	ip_all_targets.size++;
+	targets->data[targets->size] = id;
+	targets->size++;
+}
+
+void ip_merge_targets()
+{
+	struct ip_targets_t* my_targets = &ip_all_thread_contexts[ip_my_thread_num].targets;
+	size_t targets_count = 0;
+	size_t offset = 0;
+	for(int i = 0; i < ip_thread_count; i++)
+	{
+		if(i == ip_my_thread_num)
+		{
+			offset = targets_count;
+		}
+		targets_count += ip_all_thread_contexts[i].targets.size;
+	}
+	if(targets_count < ip_target_bitmap_words_count)
+	{
+		// A vertex is the target of one thread only and there are never more targets than vertices, so ip_next_targets needs no reallocation.
+		memcpy(ip_next_targets.data + offset, my_targets->data, sizeof(IP_VERTEX_ID_TYPE) * my_targets->size);
+	}
+	else
+	{
+		// Scanning the bitmap costs no more than the targets, and it gives them in the order of the vertices, which the fetching and compute phases benefit from.
+		size_t first_word = ip_target_bitmap_words_count * ip_my_thread_num / ip_thread_count;
+		size_t last_word = ip_target_bitmap_words_count * (ip_my_thread_num + 1) / ip_thread_count;
+		size_t my_count = 0;
+		for(size_t i = first_word; i < last_word; i++)
+		{
+			my_count += __builtin_popcountll(atomic_load_explicit(&ip_target_bitmap[i], memory_order_relaxed));
+		}
+		ip_all_thread_contexts[ip_my_thread_num].bitmap_targets_count = my_count;
+		// All ranges must be counted before any thread knows where to write.
+		#pragma omp barrier
+		size_t position = 0;
+		targets_count = 0;
+		for(int i = 0; i < ip_thread_count; i++)
+		{
+			if(i == ip_my_thread_num)
+			{
+				position = targets_count;
+			}
+			targets_count += ip_all_thread_contexts[i].bitmap_targets_count;
+		}
+		for(size_t i = first_word; i < last_word; i++)
+		{
+			uint64_t bits = atomic_load_explicit(&ip_target_bitmap[i], memory_order_relaxed);
+			if(bits != 0)
+			{
+				// Only this thread reads this word, it is cleared for next superstep.
+				atomic_store_explicit(&ip_target_bitmap[i], 0, memory_order_relaxed);
+				while(bits != 0)
+				{
+					ip_next_targets.data[position] = i * 64 + __builtin_ctzll(bits);
+					bits &= bits - 1;
+					position++;
+				}
+			}
+		}
+	}
+	// All threads must have got their offset before the targets of any thread are emptied.
+	#pragma omp barrier
+	#pragma omp single
+	{
+		ip_next_targets.size = targets_count;
+		for(int i = 0; i < ip_thread_count; i++)
+		{
+			ip_all_thread_contexts[i].targets.size = 0;
+		}
+	}
 }
 
 bool ip_has_message(struct ip_vertex_t* v)
@@ -54,24 +120,56 @@ bool ip_get_next_message(struct ip_vertex_t* v, IP_MESSAGE_TYPE* message_value)
 
 void ip_send_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
 {
-	(void)(id);
-	(void)(message);
-	printf("The function send_message should not be used in the SINGLE_BROADCAST \
+	#ifdef IP_USE_SIDE_MAILBOXES
+		// The recipient must fetch and compute at next superstep like any vertex reached by a broadcast.
+		ip_mark_target(id);
+		ip_bin_message(id, message);
+	#else
+		(void)(id);
+		(void)(message);
+		printf("The function send_message should not be used in the SINGLE_BROADCAST \
 version; only broadcast() should be called, and once per superstep maximum.\n");
-	exit(-1);
+		exit(-1);
+	#endif // ifdef IP_USE_SIDE_MAILBOXES
 }
 
+#ifdef IP_USE_SIDE_MAILBOXES
+	void ip_deliver_binned_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
+	{
+		struct ip_vertex_t* temp_vertex = ip_get_vertex_by_id(id);
+		if(temp_vertex->has_message)
+		{
+			ip_combine(&temp_vertex->message, message);
+		}
+		else
+		{
+			temp_vertex->has_message = true;
+			temp_vertex->message = message;
+		}
+	}
+#endif // ifdef IP_USE_SIDE_MAILBOXES
+
 void ip_broadcast(struct ip_vertex_t* v, IP_MESSAGE_TYPE message)
 {
 	ip_all_externalised_structures_1[v->id].has_broadcast_message = true;
 	ip_all_externalised_structures_1[v->id].broadcast_message = message;
 	for(IP_NEIGHBOUR_COUNT_TYPE i = 0; i < v->out_neighbour_count; i++)
 	{
-		/* Should use "#pragma omp atomic write" to protect the data race, but
-		 * since all threads would race to put the same value in the variable,
-		 * it has been purposely left unprotected.
-		 */
-		ip_all_externalised_structures_2[v->out_neighbours[i]].broadcast_target = true;
+		ip_mark_target(v->out_neighbours[i]);
+	}
+}
+
+void ip_mark_target(IP_VERTEX_ID_TYPE id)
+{
+	struct ip_targets_t* my_targets = &ip_all_thread_contexts[ip_my_thread_num].targets;
+	uint64_t mask = ((uint64_t)1) << (id % 64);
+	// The thread that sets the bit is the only one to record the target; the plain load spares the atomic operation to vertices already found.
+	if((atomic_load_explicit(&ip_target_bitmap[id / 64], memory_order_relaxed) & mask) == 0 &&
+	   (atomic_fetch_or_explicit(&ip_target_bitmap[id / 64], mask, memory_order_relaxed) & mask) == 0 &&
+	   my_targets->size < ip_target_bitmap_words_count)
+	{
+		// Beyond that many targets, they are gathered from the bitmap so the list is no longer needed.
+		ip_add_target(my_targets, id);
 	}
 }
 
@@ -108,7 +206,6 @@ void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
 	for(IP_VERTEX_ID_TYPE i = first; i <= last; i++)
 	{
 		ip_all_vertices[i].id = i;
-		ip_all_externalised_structures_2[i].broadcast_target = false;
 		ip_all_vertices[i].has_message = false;
 		ip_all_externalised_structures_1[i].has_broadcast_message = false;
 		#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
@@ -133,13 +230,29 @@ void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
 	}
 }
 
+void ip_init_thread_context(struct ip_thread_context_t* context)
+{
+	context->executed_vertices_count = 0;
+	context->targets.size = 0;
+	context->targets.max_size = 0;
+	context->targets.data = NULL;
+}
+
 void ip_init_specific()
 {
 	ip_all_targets.max_size = ip_get_vertices_count();
 	ip_all_targets.size = ip_get_vertices_count();
 	ip_all_targets.data = ip_safe_malloc(sizeof(IP_VERTEX_ID_TYPE) * ip_all_targets.max_size);
+	ip_next_targets.max_size = ip_get_vertices_count();
+	ip_next_targets.size = 0;
+	ip_next_targets.data = ip_safe_malloc(sizeof(IP_VERTEX_ID_TYPE) * ip_next_targets.max_size);
 	ip_all_externalised_structures_1 = (struct ip_externalised_structure_1_t*)ip_safe_malloc(sizeof(struct ip_externalised_structure_1_t) * ip_get_vertices_count());
-	ip_all_externalised_structures_2 = (struct ip_externalised_structure_2_t*)ip_safe_malloc(sizeof(struct ip_externalised_structure_2_t) * ip_get_vertices_count());
+	ip_target_bitmap_words_count = (ip_get_vertices_count() + 63) / 64;
+	ip_target_bitmap = (_Atomic uint64_t*)ip_safe_malloc(sizeof(_Atomic uint64_t) * ip_target_bitmap_words_count);
+	for(size_t i = 0; i < ip_target_bitmap_words_count; i++)
+	{
+		atomic_init(&ip_target_bitmap[i], 0);
+	}
 }
 
 int ip_run()
@@ -149,50 +262,28 @@ int ip_run()
 	double timer_superstep_stop = 0;
 
 	#ifdef IP_ENABLE_THREAD_PROFILING
-		double* timer_compute_start = malloc(sizeof(double) * ip_thread_count);
-		double* timer_compute_stop = malloc(sizeof(double) * ip_thread_count);
-		double* timer_compute_total = malloc(sizeof(double) * ip_thread_count);
-		double* timer_target_filtering_start = malloc(sizeof(double) * ip_thread_count);
-		double* timer_target_filtering_stop = malloc(sizeof(double) * ip_thread_count);
-		double* timer_target_filtering_total = malloc(sizeof(double) * ip_thread_count);
-		double* timer_message_fetching_start = malloc(sizeof(double) * ip_thread_count);
-		double* timer_message_fetching_stop = malloc(sizeof(double) * ip_thread_count);
-		double* timer_message_fetching_total = malloc(sizeof(double) * ip_thread_count);
-		double* timer_state_reseting_start = malloc(sizeof(double) * ip_thread_count);
-		double* timer_state_reseting_stop = malloc(sizeof(double) * ip_thread_count);
-		double* timer_state_reseting_total = malloc(sizeof(double) * ip_thread_count);
-		size_t* timer_edge_count = malloc(sizeof(size_t) * ip_thread_count);
 		size_t timer_edge_count_total = 0;
 	#endif
 
 	#ifdef IP_ENABLE_THREAD_PROFILING
-		#pragma omp parallel default(none) shared(ip_all_targets, \
+		#pragma omp parallel default(none) shared(ip_all_thread_contexts, \
+												  ip_all_targets, \
+												  ip_next_targets, \
+												  ip_target_bitmap, \
 												  ip_thread_count, \
 												  ip_all_externalised_structures_1, \
-												  ip_all_externalised_structures_2, \
 												  ip_active_vertices, \
-												  timer_compute_start, \
-												  timer_compute_stop, \
-												  timer_compute_total, \
-												  timer_target_filtering_start, \
-												  timer_target_filtering_stop, \
-												  timer_target_filtering_total, \
-												  timer_message_fetching_start, \
-												  timer_message_fetching_stop, \
-												  timer_message_fetching_total, \
-												  timer_state_reseting_start, \
-												  timer_state_reseting_stop, \
-												  timer_state_reseting_total, \
-												  timer_edge_count, \
 												  timer_edge_count_total, \
 												  timer_superstep_total, \
 												  timer_superstep_start, \
 												  timer_superstep_stop)
 	#else
-		#pragma omp parallel default(none) shared(ip_all_targets, \
+		#pragma omp parallel default(none) shared(ip_all_thread_contexts, \
+												  ip_all_targets, \
+												  ip_next_targets, \
+												  ip_target_bitmap, \
 												  ip_thread_count, \
 												  ip_all_externalised_structures_1, \
-												  ip_all_externalised_structures_2, \
 												  ip_active_vertices, \
 												  timer_superstep_total, \
 												  timer_superstep_start, \
@@ -215,9 +306,9 @@ int ip_run()
 			// COMPUTE PHASE //
 			//////////////////
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_compute_start[ip_my_thread_num] = omp_get_wtime();
-				timer_compute_stop[ip_my_thread_num] = timer_compute_start[ip_my_thread_num];
-				timer_edge_count[ip_my_thread_num] = 0;
+				ip_all_thread_contexts[ip_my_thread_num].timer_compute_start = omp_get_wtime();
+				ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop = ip_all_thread_contexts[ip_my_thread_num].timer_compute_start;
+				ip_all_thread_contexts[ip_my_thread_num].timer_edge_count = 0;
 			#endif
 			struct ip_vertex_t* temp_vertex = NULL;
 			#ifdef IP_ENABLE_THREAD_PROFILING
@@ -229,40 +320,30 @@ int ip_run()
 			{
 				temp_vertex = ip_get_vertex_by_id(ip_all_targets.data[i]);
 				ip_compute(temp_vertex);
+				ip_all_thread_contexts[ip_my_thread_num].executed_vertices_count++;
 				#ifdef IP_ENABLE_THREAD_PROFILING
-					timer_compute_stop[ip_my_thread_num] = omp_get_wtime();
-					timer_edge_count[ip_my_thread_num] += temp_vertex->in_neighbour_count;
+					ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop = omp_get_wtime();
+					ip_all_thread_contexts[ip_my_thread_num].timer_edge_count += temp_vertex->in_neighbour_count;
 					timer_edge_count_total += temp_vertex->out_neighbour_count;
 				#endif
 			}
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_compute_total[ip_my_thread_num] = timer_compute_stop[ip_my_thread_num] - timer_compute_start[ip_my_thread_num];
+				ip_all_thread_contexts[ip_my_thread_num].timer_compute_total = ip_all_thread_contexts[ip_my_thread_num].timer_compute_stop - ip_all_thread_contexts[ip_my_thread_num].timer_compute_start;
 			#endif
 		
 			/////////////////////////////
 			// TARGET FILTERING PHASE //
 			///////////////////////////
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_target_filtering_start[ip_my_thread_num] = omp_get_wtime();
-				timer_target_filtering_stop[ip_my_thread_num] = timer_target_filtering_start[ip_my_thread_num];
+				ip_all_thread_contexts[ip_my_thread_num].timer_target_filtering_start = omp_get_wtime();
+				ip_all_thread_contexts[ip_my_thread_num].timer_target_filtering_stop = ip_all_thread_contexts[ip_my_thread_num].timer_target_filtering_start;
+			#endif
+			ip_merge_targets();
+			#ifdef IP_ENABLE_THREAD_PROFILING
+				ip_all_thread_contexts[ip_my_thread_num].timer_target_filtering_stop = omp_get_wtime();
 			#endif
-			#pragma omp single
-			{
-				ip_all_targets.size = 0;
-				for(size_t i = 0; i < ip_get_vertices_count(); i++)
-				{
-					temp_vertex = ip_get_vertex_by_location(i);
-					if(ip_all_externalised_structures_2[i].broadcast_target)
-					{
-						ip_add_target(temp_vertex->id);
-					}
-				}
-				#ifdef IP_ENABLE_THREAD_PROFILING
-					timer_target_filtering_stop[ip_my_thread_num] = omp_get_wtime();
-				#endif
-			}
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_target_filtering_total[ip_my_thread_num] = timer_target_filtering_stop[ip_my_thread_num] - timer_target_filtering_start[ip_my_thread_num];
+				ip_all_thread_contexts[ip_my_thread_num].timer_target_filtering_total = ip_all_thread_contexts[ip_my_thread_num].timer_target_filtering_stop - ip_all_thread_contexts[ip_my_thread_num].timer_target_filtering_start;
 			#endif
 	
 			/////////////////////////////
@@ -271,47 +352,67 @@ int ip_run()
 			// Get the messages broadcasted by neighbours, but only for those
 			// who have neighbours who broadcasted.
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_message_fetching_start[ip_my_thread_num] = omp_get_wtime();
-				timer_message_fetching_stop[ip_my_thread_num] = timer_message_fetching_start[ip_my_thread_num];
+				ip_all_thread_contexts[ip_my_thread_num].timer_message_fetching_start = omp_get_wtime();
+				ip_all_thread_contexts[ip_my_thread_num].timer_message_fetching_stop = ip_all_thread_contexts[ip_my_thread_num].timer_message_fetching_start;
 			#endif
 			#pragma omp for schedule(runtime)
-			for(size_t i = 0; i < ip_all_targets.size; i++)
+			for(size_t i = 0; i < ip_next_targets.size; i++)
 			{
-				temp_vertex = ip_get_vertex_by_id(ip_all_targets.data[i]);
-				if(ip_all_externalised_structures_2[temp_vertex->id].broadcast_target)
+				IP_VERTEX_ID_TYPE target = ip_next_targets.data[i];
+				// Every bit set belongs to a target, so clearing the words of all targets empties the bitmap for next superstep.
+				if(atomic_load_explicit(&ip_target_bitmap[target / 64], memory_order_relaxed) != 0)
 				{
-					ip_fetch_broadcast_messages(temp_vertex);
-					ip_all_externalised_structures_2[temp_vertex->id].broadcast_target = false;
+					atomic_store_explicit(&ip_target_bitmap[target / 64], 0, memory_order_relaxed);
 				}
+				ip_fetch_broadcast_messages(ip_get_vertex_by_id(target));
 				#ifdef IP_ENABLE_THREAD_PROFILING
-					timer_message_fetching_stop[ip_my_thread_num] = omp_get_wtime();
+					ip_all_thread_contexts[ip_my_thread_num].timer_message_fetching_stop = omp_get_wtime();
 				#endif
 			}
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_message_fetching_total[ip_my_thread_num] = timer_message_fetching_stop[ip_my_thread_num] - timer_message_fetching_start[ip_my_thread_num];
+				ip_all_thread_contexts[ip_my_thread_num].timer_message_fetching_total = ip_all_thread_contexts[ip_my_thread_num].timer_message_fetching_stop - ip_all_thread_contexts[ip_my_thread_num].timer_message_fetching_start;
 			#endif
 
+			#ifdef IP_USE_SIDE_MAILBOXES
+				//////////////////////////////////
+				// SIDE MAILBOX DELIVERY PHASE //
+				////////////////////////////////
+				// The messages sent to a given vertex are combined into the mailboxes of the targets, once they have fetched.
+				ip_apply_bins();
+			#endif // ifdef IP_USE_SIDE_MAILBOXES
+
 			///////////////////////////
 			// STATE RESETING PHASE //
 			/////////////////////////
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_state_reseting_start[ip_my_thread_num] = omp_get_wtime();
-				timer_state_reseting_stop[ip_my_thread_num] = timer_state_reseting_start[ip_my_thread_num];
+				ip_all_thread_contexts[ip_my_thread_num].timer_state_reseting_start = omp_get_wtime();
+				ip_all_thread_contexts[ip_my_thread_num].timer_state_reseting_stop = ip_all_thread_contexts[ip_my_thread_num].timer_state_reseting_start;
 			#endif
+			// Only the vertices executed at current superstep may have broadcasted.
 			#pragma omp for schedule(runtime)
-			for(size_t i = 0; i < ip_get_vertices_count(); i++)
+			for(size_t i = 0; i < ip_all_targets.size; i++)
 			{
-				ip_all_externalised_structures_1[i].has_broadcast_message = false;
+				ip_all_externalised_structures_1[ip_all_targets.data[i]].has_broadcast_message = false;
 				#ifdef IP_ENABLE_THREAD_PROFILING
-					timer_state_reseting_stop[ip_my_thread_num] = omp_get_wtime();
+					ip_all_thread_contexts[ip_my_thread_num].timer_state_reseting_stop = omp_get_wtime();
 				#endif
 			}
 			#ifdef IP_ENABLE_THREAD_PROFILING
-				timer_state_reseting_total[ip_my_thread_num] = timer_state_reseting_stop[ip_my_thread_num] - timer_state_reseting_start[ip_my_thread_num];
+				ip_all_thread_contexts[ip_my_thread_num].timer_state_reseting_total = ip_all_thread_contexts[ip_my_thread_num].timer_state_reseting_stop - ip_all_thread_contexts[ip_my_thread_num].timer_state_reseting_start;
 			#endif
 			
+			#ifdef IP_NEEDS_REMOTE_VALUES
+				ip_commit_values();
+			#endif // ifdef IP_NEEDS_REMOTE_VALUES
 			#pragma omp single
 			{
+				// The implicit barriers of the OpenMP fors above guarantee that all threads are done computing.
+				ip_active_vertices = 0;
+				for(int i = 0; i < ip_thread_count; i++)
+				{
+					ip_active_vertices += ip_all_thread_contexts[i].executed_vertices_count;
+					ip_all_thread_contexts[i].executed_vertices_count = 0;
+				}
 				timer_superstep_stop = omp_get_wtime();
 				timer_superstep_total += timer_superstep_stop - timer_superstep_start;
 				printf("Superstep%zuDuration:%f\n", ip_get_superstep(), timer_superstep_stop - timer_superstep_start);
@@ -335,32 +436,32 @@ int ip_run()
 					printf("\n|   Compute |");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf(" %8.3fs |", timer_compute_total[i]);
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_compute_total);
 					}
 					printf("\n| Filtering |");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf(" %8.3fs |", timer_target_filtering_total[i]);
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_target_filtering_total);
 					}
 					printf("\n|  Fetching |");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf(" %8.3fs |", timer_message_fetching_total[i]);
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_message_fetching_total);
 					}
 					printf("\n|     Reset |");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf(" %8.3fs |", timer_state_reseting_total[i]);
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_state_reseting_total);
 					}
 					printf("\n|     Total |");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf(" %8.3fs |", timer_message_fetching_total[i] + timer_target_filtering_total[i] + timer_compute_total[i] + timer_state_reseting_total[i]);
+						printf(" %8.3fs |", ip_all_thread_contexts[i].timer_message_fetching_total + ip_all_thread_contexts[i].timer_target_filtering_total + ip_all_thread_contexts[i].timer_compute_total + ip_all_thread_contexts[i].timer_state_reseting_total);
 					}
 					printf("\n| EdgeCount |");
 					for(int i = 0; i < ip_thread_count; i++)
 					{
-						printf(" %8.3f%% |", 100.0 * (((double)timer_edge_count[i]) / ((double)timer_edge_count_total)));
+						printf(" %8.3f%% |", 100.0 * (((double)ip_all_thread_contexts[i].timer_edge_count) / ((double)timer_edge_count_total)));
 					}
 					printf("\n+-----------+");
 					for(int i = 0; i < ip_thread_count; i++)
@@ -370,6 +471,10 @@ int ip_run()
 					printf("\n");
 					timer_edge_count_total = 0;
 				#endif
+				struct ip_targets_t temp_targets = ip_all_targets;
+				ip_all_targets = ip_next_targets;
+				ip_next_targets = temp_targets;
+				ip_reduce_aggregators();
 				ip_increment_superstep();
  			} // End of OpenMP single region
 		} // End of superstep processing loop
@@ -377,22 +482,8 @@ int ip_run()
 
 	printf("Total time of supersteps: %fs.\n", timer_superstep_total);
 
-	#ifdef IP_ENABLE_THREAD_PROFILING
-		free(timer_compute_start);
-		free(timer_compute_stop);
-		free(timer_compute_total);
-		free(timer_target_filtering_start);
-		free(timer_target_filtering_stop);
-		free(timer_target_filtering_total);
-		free(timer_message_fetching_start);
-		free(timer_message_fetching_stop);
-		free(timer_message_fetching_total);
-		free(timer_state_reseting_start);
-		free(timer_state_reseting_stop);
-		free(timer_state_reseting_total);
-	#endif
 	free(ip_all_externalised_structures_1);
-	free(ip_all_externalised_structures_2);
+	free(ip_target_bitmap);
 	
 	return 0;
 }
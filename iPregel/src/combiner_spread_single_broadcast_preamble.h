@@ -18,6 +18,8 @@
 #ifndef COMBINER_SPREAD_SINGLE_BROADCAST_H_INCLUDED
 #define COMBINER_SPREAD_SINGLE_BROADCAST_H_INCLUDED
 
+#include <stdatomic.h>
+
 #ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
 	#define IP_NEEDS_OUT_NEIGHBOUR_IDS
 #endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
@@ -56,18 +58,54 @@ struct ip_externalised_structure_1_t
 	/// Contains the message to broadcast
 	IP_MESSAGE_TYPE broadcast_message;
 };
-/// Contains the passive broadcast attribute
-struct ip_externalised_structure_2_t
-{
-	/// Indicates whether this vertex has one of its in-neighbours at least who broadcasts. That tells whether that vertex will have to fetch messages from its in-neighbours or not.
-	bool broadcast_target;
-};
 /// Contains the active broadcast attributes for all vertices
 struct ip_externalised_structure_1_t* ip_all_externalised_structures_1 = NULL;
-/// Contains the passive broadcast attributes for all vertices
-struct ip_externalised_structure_2_t* ip_all_externalised_structures_2 = NULL;
-/// This variable contains the targets.
+/// The number of 64-bit words in ip_target_bitmap.
+size_t ip_target_bitmap_words_count = 0;
+/// One bit per vertex, set when one of its in-neighbours at least broadcasts. That tells whether that vertex will have to fetch messages from its in-neighbours or not.
+_Atomic uint64_t* ip_target_bitmap = NULL;
+/// This variable contains the targets to execute at current superstep.
 struct ip_targets_t ip_all_targets;
+/// This variable contains the targets of next superstep, gathered from the targets found by every thread.
+struct ip_targets_t ip_next_targets;
+/// This structure holds the state private to each thread; each instance sits on its own cache lines to avoid false sharing.
+struct ip_thread_context_t
+{
+	/// The number of vertices this thread executed at current superstep.
+	_Alignas(IP_CACHE_LINE_SIZE) size_t executed_vertices_count;
+	/// The targets that this thread is the first to find at current superstep, up to as many as words in the target bitmap.
+	struct ip_targets_t targets;
+	/// The number of targets that this thread gathers from its range of the target bitmap, when the targets are many.
+	size_t bitmap_targets_count;
+	#ifdef IP_ENABLE_THREAD_PROFILING
+		/// The time at which this thread started the compute phase at current superstep.
+		double timer_compute_start;
+		/// The time at which this thread stopped the compute phase at current superstep.
+		double timer_compute_stop;
+		/// The time spent by this thread in the compute phase, accumulated over all supersteps.
+		double timer_compute_total;
+		/// The time at which this thread started fetching messages at current superstep.
+		double timer_message_fetching_start;
+		/// The time at which this thread stopped fetching messages at current superstep.
+		double timer_message_fetching_stop;
+		/// The time spent by this thread in fetching messages, accumulated over all supersteps.
+		double timer_message_fetching_total;
+		/// The time at which this thread started reseting vertex states at current superstep.
+		double timer_state_reseting_start;
+		/// The time at which this thread stopped reseting vertex states at current superstep.
+		double timer_state_reseting_stop;
+		/// The time spent by this thread in reseting vertex states, accumulated over all supersteps.
+		double timer_state_reseting_total;
+		/// The time at which this thread started filtering the targets at current superstep.
+		double timer_target_filtering_start;
+		/// The time at which this thread stopped filtering the targets at current superstep.
+		double timer_target_filtering_stop;
+		/// The time spent by this thread in filtering the targets, accumulated over all supersteps.
+		double timer_target_filtering_total;
+		/// The number of out-edges processed by this thread at current superstep.
+		size_t timer_edge_count;
+	#endif // ifdef IP_ENABLE_THREAD_PROFILING
+};
 /// This structure defines the structure of a vertex.
 struct ip_vertex_t
 {
@@ -107,11 +145,36 @@ struct ip_vertex_t
 
 // Prototypes
 /**
- * @brief This functions add the identifier \p id to the targets.
+ * @brief This functions add the identifier \p id to the targets \p targets.
+ * @param[inout] targets The targets to extend.
  * @param[in] id The identifier of the new target.
- * @post \p id is added to the targets.
+ * @post \p id is added to \p targets.
+ **/
+void ip_add_target(struct ip_targets_t* targets, IP_VERTEX_ID_TYPE id);
+/**
+ * @brief This function makes the vertex \p id a target of next superstep.
+ * @details The calling thread records \p id in its own targets if it is the
+ * first to set the bit of \p id in the target bitmap.
+ * @param[in] id The identifier of the target.
+ * @post The bit of \p id is set in the target bitmap.
+ **/
+void ip_mark_target(IP_VERTEX_ID_TYPE id);
+/**
+ * @brief This function gathers the targets found by all threads into
+ * ip_next_targets.
+ * @details Every thread copies its own targets at the position given by the
+ * number of targets found by the threads before it, so the targets are merged
+ * in parallel and in a time proportional to their number. When there are at
+ * least as many targets as words in the target bitmap, every thread gathers
+ * instead the targets of its range of the bitmap, so that they are ordered by
+ * identifier. This function
+ * contains OpenMP barriers and must therefore be called by all threads of the
+ * team.
+ * @pre All threads are done computing.
+ * @post ip_next_targets contains the targets of all threads, whose own targets
+ * are emptied.
  **/
-void ip_add_target(IP_VERTEX_ID_TYPE id);
+void ip_merge_targets();
 /**
  * @brief This functions gathers and combines all the messages destined to the
  * vertex \p v.
@@ -23,22 +23,31 @@
 #endif
 #include <omp.h> // omp_set_schedule
 #include <string.h>
+#include <math.h> // INFINITY
 #define STRINGIFY(x) STRINGIFY_LITERAL(x)
 #define STRINGIFY_LITERAL(x) # x
 
-#ifdef IP_USE_SPREAD
+#if defined(IP_WITHOUT_COMBINER)
+	#include "no_combiner_postamble.h"
+#elif defined(IP_USE_ASYNCHRONOUS)
+	#include "combiner_asynchronous_postamble.h"
+#elif defined(IP_USE_BLOCK_CENTRIC)
+	#include "combiner_block_centric_postamble.h"
+#elif defined(IP_USE_HYBRID)
+	#include "combiner_hybrid_postamble.h"
+#elif defined(IP_USE_SPREAD)
 	#ifdef IP_USE_SINGLE_BROADCAST
 		#include "combiner_spread_single_broadcast_postamble.h"
 	#else // ifndef IP_USE_SINGLE_BROADCAST
 		#include "combiner_spread_postamble.h"
 	#endif // if(n)def IP_USE_SINGLE_BROADCAST
-#else // ifndef IP_USE_SPREAD
+#else // if !defined(IP_USE_HYBRID) && !defined(IP_USE_SPREAD)
 	#ifdef IP_USE_SINGLE_BROADCAST
 		#include "combiner_single_broadcast_postamble.h"
 	#else // ifndef IP_USE_SINGLE_BROADCAST
 		#include "combiner_postamble.h"
 	#endif // if(n)def IP_USE_SINGLE_BROADCAST
-#endif // if(n)def IP_USE_SPREAD
+#endif // if defined(IP_WITHOUT_COMBINER)
 
 size_t ip_get_superstep()
 {
@@ -100,6 +109,754 @@ struct ip_vertex_t* ip_get_vertex_by_id(IP_VERTEX_ID_TYPE id)
 	#endif
 }
 
+#ifndef IP_WITHOUT_COMBINER
+	#ifdef IP_COMPOSITE_MESSAGES
+		struct ip_message_lock_t* ip_lock_mailbox(IP_MESSAGE_TYPE* mailbox)
+		{
+			struct ip_message_lock_t* lock = &ip_message_locks[((uintptr_t)mailbox / sizeof(IP_MESSAGE_TYPE)) % IP_MESSAGE_LOCK_STRIPES];
+			while(atomic_exchange_explicit(&lock->locked, true, memory_order_acquire))
+			{
+				while(atomic_load_explicit(&lock->locked, memory_order_relaxed))
+				{
+				}
+			}
+			return lock;
+		}
+
+		void ip_unlock_mailbox(struct ip_message_lock_t* lock)
+		{
+			atomic_store_explicit(&lock->locked, false, memory_order_release);
+		}
+	#endif // ifdef IP_COMPOSITE_MESSAGES
+
+	bool ip_cas(IP_MESSAGE_TYPE* mailbox, IP_MESSAGE_TYPE message)
+	{
+		#ifdef IP_COMPOSITE_MESSAGES
+			if(IP_MESSAGE_CAS_ABLE)
+			{
+				// The first read must be atomic too; a torn value may compare equal to its combination and skip the exchange.
+				IP_MESSAGE_TYPE old_value;
+				__atomic_load(mailbox, &old_value, __ATOMIC_RELAXED);
+				IP_MESSAGE_TYPE new_value = old_value;
+				ip_combine(&new_value, message);
+				while(memcmp(&new_value, &old_value, sizeof(IP_MESSAGE_TYPE)) != 0 && !__atomic_compare_exchange(mailbox, &old_value, &new_value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+				{
+					new_value = old_value;
+					ip_combine(&new_value, message);
+				}
+				return memcmp(&new_value, &old_value, sizeof(IP_MESSAGE_TYPE)) != 0;
+			}
+			else
+			{
+				struct ip_message_lock_t* lock = ip_lock_mailbox(mailbox);
+				IP_MESSAGE_TYPE old_value = *mailbox;
+				ip_combine(mailbox, message);
+				bool changed = memcmp(mailbox, &old_value, sizeof(IP_MESSAGE_TYPE)) != 0;
+				ip_unlock_mailbox(lock);
+				return changed;
+			}
+		#elif defined(IP_COMBINER_MIN) || defined(IP_COMBINER_MAX)
+			IP_MESSAGE_TYPE old_value;
+			__atomic_load(mailbox, &old_value, __ATOMIC_RELAXED);
+			// A failed exchange refreshes old_value, so the loop stops as soon as another thread wrote a better message.
+			#ifdef IP_COMBINER_MIN
+				while(message < old_value && !__atomic_compare_exchange(mailbox, &old_value, &message, true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+				{
+				}
+				return message < old_value;
+			#else
+				while(message > old_value && !__atomic_compare_exchange(mailbox, &old_value, &message, true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+				{
+				}
+				return message > old_value;
+			#endif // ifdef IP_COMBINER_MIN
+		#elif defined(IP_COMBINER_SUM)
+			__atomic_fetch_add(mailbox, message, __ATOMIC_SEQ_CST);
+			return message != 0;
+		#elif defined(IP_COMBINER_FLOATING_SUM)
+			IP_MESSAGE_TYPE old_value;
+			__atomic_load(mailbox, &old_value, __ATOMIC_RELAXED);
+			IP_MESSAGE_TYPE new_value = old_value + message;
+			while(!__atomic_compare_exchange(mailbox, &old_value, &new_value, true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+			{
+				new_value = old_value + message;
+			}
+			return new_value != old_value;
+		#else
+			IP_MESSAGE_TYPE old_value = *mailbox;
+			IP_MESSAGE_TYPE new_value = old_value;
+			ip_combine(&new_value, message);
+			while(new_value != old_value && !atomic_compare_exchange_strong(mailbox, &old_value, new_value))
+			{
+				new_value = old_value;
+				ip_combine(&new_value, message);
+			}
+			// The loop ends either because the message changes nothing or because the exchange succeeded.
+			return new_value != old_value;
+		#endif // ifdef IP_COMPOSITE_MESSAGES
+	}
+
+	bool ip_deliver_message(IP_MAILBOX_FLAG_TYPE* flag, IP_MESSAGE_TYPE* mailbox, IP_MESSAGE_TYPE message)
+	{
+		#ifdef IP_COMBINER_IDENTITY
+			ip_cas(mailbox, message);
+			// Only the first sender pays for the exchange, the others see the flag already set.
+			return atomic_load_explicit(flag, memory_order_relaxed) == IP_MAILBOX_EMPTY && atomic_exchange(flag, IP_MAILBOX_FULL) == IP_MAILBOX_EMPTY;
+		#else
+			unsigned char state = atomic_load(flag);
+			if(state == IP_MAILBOX_EMPTY && atomic_compare_exchange_strong(flag, &state, IP_MAILBOX_WRITING))
+			{
+				*mailbox = message;
+				atomic_store(flag, IP_MAILBOX_FULL);
+				return true;
+			}
+			// Someone else is storing the first message, which is only a couple of instructions away.
+			while(state != IP_MAILBOX_FULL)
+			{
+				state = atomic_load(flag);
+			}
+			ip_cas(mailbox, message);
+			return false;
+		#endif // ifdef IP_COMBINER_IDENTITY
+	}
+
+	void ip_empty_mailbox(IP_MAILBOX_FLAG_TYPE* flag, IP_MESSAGE_TYPE* mailbox)
+	{
+		#ifdef IP_COMBINER_IDENTITY
+			*mailbox = IP_COMBINER_IDENTITY;
+		#else
+			(void)(mailbox);
+		#endif // ifdef IP_COMBINER_IDENTITY
+		atomic_store_explicit(flag, IP_MAILBOX_EMPTY, memory_order_relaxed);
+	}
+#endif // ifndef IP_WITHOUT_COMBINER
+
+void ip_init_edge_stealing()
+{
+	ip_edge_stealing.items_count = 0;
+	ip_edge_stealing.max_items_count = 0;
+	ip_edge_stealing.covers_all_vertices = false;
+	ip_edge_stealing.reuse_bounds = false;
+	ip_edge_stealing.workload_prefix = NULL;
+	ip_edge_stealing.thread_workloads = (size_t*)ip_safe_malloc(sizeof(size_t) * ip_thread_count);
+	ip_edge_stealing.chunk_bounds = (size_t*)ip_safe_malloc(sizeof(size_t) * (ip_thread_count * ip_edge_stealing_chunks_per_thread + 1));
+	ip_edge_stealing.deques = (struct ip_chunk_deque_t*)ip_safe_malloc(sizeof(struct ip_chunk_deque_t) * ip_thread_count);
+}
+
+void ip_prepare_chunks(const IP_VERTEX_ID_TYPE* ids, size_t items_count)
+{
+	size_t chunks_count = ip_thread_count * ip_edge_stealing_chunks_per_thread;
+	int my_thread_num = omp_get_thread_num();
+
+	#pragma omp single
+	{
+		ip_edge_stealing.reuse_bounds = ids == NULL && ip_edge_stealing.covers_all_vertices;
+		if(!ip_edge_stealing.reuse_bounds)
+		{
+			if(ip_edge_stealing.max_items_count < items_count)
+			{
+				ip_edge_stealing.workload_prefix = ip_safe_realloc(ip_edge_stealing.workload_prefix, sizeof(size_t) * (items_count + 1));
+				ip_edge_stealing.max_items_count = items_count;
+			}
+			ip_edge_stealing.items_count = items_count;
+			ip_edge_stealing.covers_all_vertices = ids == NULL;
+		}
+	} // The implicit barrier makes the decision visible to all threads.
+
+	if(!ip_edge_stealing.reuse_bounds)
+	{
+		// Each thread sums the workload of a contiguous block of items...
+		size_t block_first = items_count * my_thread_num / ip_thread_count;
+		size_t block_last = items_count * (my_thread_num + 1) / ip_thread_count;
+		size_t workload = 0;
+		for(size_t i = block_first; i < block_last; i++)
+		{
+			struct ip_vertex_t* v = (ids == NULL) ? ip_get_vertex_by_location(i) : ip_get_vertex_by_id(ids[i]);
+			ip_edge_stealing.workload_prefix[i] = workload;
+			#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+				workload += v->out_neighbour_count + 1;
+			#else
+				(void)(v);
+				workload++;
+			#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+		}
+		ip_edge_stealing.thread_workloads[my_thread_num] = workload;
+		#pragma omp barrier
+
+		// ...then offsets it by the workload of the blocks before.
+		size_t offset = 0;
+		size_t total_workload = 0;
+		for(int i = 0; i < ip_thread_count; i++)
+		{
+			if(i < my_thread_num)
+			{
+				offset += ip_edge_stealing.thread_workloads[i];
+			}
+			total_workload += ip_edge_stealing.thread_workloads[i];
+		}
+		for(size_t i = block_first; i < block_last; i++)
+		{
+			ip_edge_stealing.workload_prefix[i] += offset;
+		}
+		if(my_thread_num == 0)
+		{
+			ip_edge_stealing.workload_prefix[items_count] = total_workload;
+			ip_edge_stealing.chunk_bounds[chunks_count] = items_count;
+		}
+		#pragma omp barrier
+
+		// Each chunk starts at the first item whose preceding workload reaches its share.
+		for(size_t i = my_thread_num * ip_edge_stealing_chunks_per_thread; i < (my_thread_num + 1) * ip_edge_stealing_chunks_per_thread; i++)
+		{
+			size_t target = total_workload * i / chunks_count;
+			size_t low = 0;
+			size_t high = items_count;
+			while(low < high)
+			{
+				size_t middle = low + (high - low) / 2;
+				if(ip_edge_stealing.workload_prefix[middle] < target)
+				{
+					low = middle + 1;
+				}
+				else
+				{
+					high = middle;
+				}
+			}
+			ip_edge_stealing.chunk_bounds[i] = low;
+		}
+	}
+
+	uint64_t head = my_thread_num * ip_edge_stealing_chunks_per_thread;
+	uint64_t tail = head + ip_edge_stealing_chunks_per_thread;
+	atomic_store(&ip_edge_stealing.deques[my_thread_num].head_and_tail, (head << 32) | tail);
+	// No thread may steal before all deques and chunk bounds are ready.
+	#pragma omp barrier
+}
+
+bool ip_get_next_chunk(size_t* first, size_t* last)
+{
+	int my_thread_num = omp_get_thread_num();
+	for(int i = 0; i < ip_thread_count; i++)
+	{
+		int victim = (my_thread_num + i) % ip_thread_count;
+		_Atomic uint64_t* head_and_tail = &ip_edge_stealing.deques[victim].head_and_tail;
+		uint64_t current = atomic_load(head_and_tail);
+		while((current >> 32) < (current & UINT32_MAX))
+		{
+			uint64_t head = current >> 32;
+			uint64_t tail = current & UINT32_MAX;
+			uint64_t chunk;
+			uint64_t desired;
+			if(victim == my_thread_num)
+			{
+				chunk = head;
+				desired = ((head + 1) << 32) | tail;
+			}
+			else
+			{
+				chunk = tail - 1;
+				desired = (head << 32) | (tail - 1);
+			}
+			if(atomic_compare_exchange_weak(head_and_tail, &current, desired))
+			{
+				*first = ip_edge_stealing.chunk_bounds[chunk];
+				*last = ip_edge_stealing.chunk_bounds[chunk + 1];
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+#if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_SIDE_MAILBOXES)
+	void ip_init_bins()
+	{
+		ip_bins_per_thread = (ip_get_vertices_count() + IP_PROPAGATION_BLOCKING_RANGE - 1) / IP_PROPAGATION_BLOCKING_RANGE;
+		ip_all_bins = (struct ip_bin_t*)ip_safe_malloc(sizeof(struct ip_bin_t) * ip_thread_count * ip_bins_per_thread);
+		#pragma omp parallel default(none) shared(ip_all_bins, ip_bins_per_thread)
+		{
+			struct ip_bin_t* my_bins = &ip_all_bins[omp_get_thread_num() * ip_bins_per_thread];
+			for(size_t i = 0; i < ip_bins_per_thread; i++)
+			{
+				my_bins[i].max_size = 0;
+				my_bins[i].size = 0;
+				my_bins[i].data = NULL;
+			}
+		}
+	}
+
+	void ip_bin_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
+	{
+		size_t location = ip_get_vertex_by_id(id) - ip_get_vertex_by_location(0);
+		struct ip_bin_t* my_bin = &ip_all_bins[omp_get_thread_num() * ip_bins_per_thread + location / IP_PROPAGATION_BLOCKING_RANGE];
+		if(my_bin->size == my_bin->max_size)
+		{
+			my_bin->max_size = my_bin->max_size == 0 ? 64 : my_bin->max_size * 2;
+			my_bin->data = ip_safe_realloc(my_bin->data, sizeof(struct ip_binned_message_t) * my_bin->max_size);
+		}
+
+		my_bin->data[my_bin->size].id = id;
+		my_bin->data[my_bin->size].message = message;
+		my_bin->size++;
+	}
+
+	void ip_apply_bins()
+	{
+		#pragma omp for schedule(dynamic, 1)
+		for(size_t i = 0; i < ip_bins_per_thread; i++)
+		{
+			for(int j = 0; j < ip_thread_count; j++)
+			{
+				struct ip_bin_t* bin = &ip_all_bins[j * ip_bins_per_thread + i];
+				for(size_t k = 0; k < bin->size; k++)
+				{
+					ip_deliver_binned_message(bin->data[k].id, bin->data[k].message);
+				}
+				bin->size = 0;
+			}
+		}
+	}
+#endif // if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_SIDE_MAILBOXES)
+
+#if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES)
+	bool ip_deliver_message_exclusively(IP_MAILBOX_FLAG_TYPE* flag, IP_MESSAGE_TYPE* mailbox, IP_MESSAGE_TYPE message)
+	{
+		if(atomic_load_explicit(flag, memory_order_relaxed) == IP_MAILBOX_EMPTY)
+		{
+			*mailbox = message;
+			atomic_store_explicit(flag, IP_MAILBOX_FULL, memory_order_relaxed);
+			return true;
+		}
+		ip_combine(mailbox, message);
+		return false;
+	}
+#endif // if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES)
+
+#ifdef IP_USE_SPIN_BARRIER
+	void ip_init_spin_barrier()
+	{
+		ip_spin_barrier_rounds = 0;
+		while((1 << ip_spin_barrier_rounds) < ip_thread_count)
+		{
+			ip_spin_barrier_rounds++;
+		}
+		ip_all_spin_barrier_nodes = (struct ip_spin_barrier_node_t*)ip_safe_aligned_malloc(IP_CACHE_LINE_SIZE, sizeof(struct ip_spin_barrier_node_t) * ip_thread_count);
+		for(int i = 0; i < ip_thread_count; i++)
+		{
+			for(int j = 0; j < IP_SPIN_BARRIER_MAX_ROUNDS; j++)
+			{
+				atomic_init(&ip_all_spin_barrier_nodes[i].flags[j], 0);
+			}
+			ip_all_spin_barrier_nodes[i].episode = 0;
+		}
+	}
+
+	void ip_spin_barrier()
+	{
+		struct ip_spin_barrier_node_t* my_node = &ip_all_spin_barrier_nodes[ip_my_thread_num];
+		my_node->episode++;
+		for(int round = 0; round < ip_spin_barrier_rounds; round++)
+		{
+			struct ip_spin_barrier_node_t* partner = &ip_all_spin_barrier_nodes[(ip_my_thread_num + (1 << round)) % ip_thread_count];
+			atomic_store_explicit(&partner->flags[round], my_node->episode, memory_order_release);
+			// A partner may already be in the next episode, so the flag only has to reach the current one.
+			int spins = 0;
+			while(atomic_load_explicit(&my_node->flags[round], memory_order_acquire) < my_node->episode)
+			{
+				spins++;
+				if(spins == IP_SPIN_BARRIER_SPINS)
+				{
+					spins = 0;
+					sched_yield();
+				}
+			}
+		}
+	}
+#endif // ifdef IP_USE_SPIN_BARRIER
+
+#ifdef IP_USE_HUB_BROADCASTS
+	void ip_init_hub_broadcasts()
+	{
+		ip_hubs_count = 0;
+		for(size_t i = 0; i < ip_get_vertices_count(); i++)
+		{
+			if(ip_get_vertex_by_location(i)->out_neighbour_count >= IP_HUB_DEGREE_THRESHOLD)
+			{
+				ip_hubs_count++;
+			}
+		}
+		printf("HubCount:%zu\n", ip_hubs_count);
+		ip_hub_broadcasts = (struct ip_hub_broadcast_t*)ip_safe_malloc(sizeof(struct ip_hub_broadcast_t) * (ip_hubs_count > 0 ? ip_hubs_count : 1));
+		atomic_init(&ip_hub_broadcasts_count, 0);
+		atomic_init(&ip_hub_next_chunk, 0);
+	}
+
+	bool ip_defer_hub_broadcast(struct ip_vertex_t* v, IP_MESSAGE_TYPE message)
+	{
+		if(v->out_neighbour_count < IP_HUB_DEGREE_THRESHOLD)
+		{
+			return false;
+		}
+		size_t position = atomic_fetch_add_explicit(&ip_hub_broadcasts_count, 1, memory_order_relaxed);
+		if(position >= ip_hubs_count)
+		{
+			// A hub broadcasting several times in a superstep overflows the room reserved, it broadcasts by itself instead.
+			atomic_fetch_sub_explicit(&ip_hub_broadcasts_count, 1, memory_order_relaxed);
+			return false;
+		}
+		ip_hub_broadcasts[position].vertex = v;
+		ip_hub_broadcasts[position].message = message;
+		return true;
+	}
+
+	void ip_send_hub_broadcast_chunks(size_t hub_broadcasts_count)
+	{
+		// Chunks are claimed in increasing order, so the broadcast they belong to is found by walking the broadcasts forward.
+		size_t hub_broadcast = 0;
+		size_t chunks_before = 0;
+		size_t chunk = atomic_fetch_add_explicit(&ip_hub_next_chunk, 1, memory_order_relaxed);
+		while(hub_broadcast < hub_broadcasts_count)
+		{
+			struct ip_vertex_t* v = ip_hub_broadcasts[hub_broadcast].vertex;
+			size_t chunks_count = (v->out_neighbour_count + IP_HUB_CHUNK_SIZE - 1) / IP_HUB_CHUNK_SIZE;
+			if(chunk >= chunks_before + chunks_count)
+			{
+				chunks_before += chunks_count;
+				hub_broadcast++;
+			}
+			else
+			{
+				size_t first = (chunk - chunks_before) * IP_HUB_CHUNK_SIZE;
+				size_t last = first + IP_HUB_CHUNK_SIZE < v->out_neighbour_count ? first + IP_HUB_CHUNK_SIZE : v->out_neighbour_count;
+				for(size_t i = first; i < last; i++)
+				{
+					ip_send_message(v->out_neighbours[i], ip_hub_broadcasts[hub_broadcast].message);
+				}
+				chunk = atomic_fetch_add_explicit(&ip_hub_next_chunk, 1, memory_order_relaxed);
+			}
+		}
+	}
+
+	void ip_run_hub_broadcasts()
+	{
+		// All broadcasts were deferred before the barrier ending the compute phase, so all threads take the same decision.
+		size_t hub_broadcasts_count = atomic_load_explicit(&ip_hub_broadcasts_count, memory_order_relaxed);
+		if(hub_broadcasts_count == 0)
+		{
+			return;
+		}
+		ip_send_hub_broadcast_chunks(hub_broadcasts_count);
+		#pragma omp barrier
+		// Nobody defers nor claims until the barrier ending the next compute phase.
+		if(ip_my_thread_num == 0)
+		{
+			atomic_store_explicit(&ip_hub_broadcasts_count, 0, memory_order_relaxed);
+			atomic_store_explicit(&ip_hub_next_chunk, 0, memory_order_relaxed);
+		}
+	}
+
+	void ip_run_hub_broadcasts_alone()
+	{
+		size_t hub_broadcasts_count = atomic_load_explicit(&ip_hub_broadcasts_count, memory_order_relaxed);
+		if(hub_broadcasts_count > 0)
+		{
+			ip_send_hub_broadcast_chunks(hub_broadcasts_count);
+			atomic_store_explicit(&ip_hub_broadcasts_count, 0, memory_order_relaxed);
+			atomic_store_explicit(&ip_hub_next_chunk, 0, memory_order_relaxed);
+		}
+	}
+
+	void ip_free_hub_broadcasts()
+	{
+		ip_safe_free(ip_hub_broadcasts);
+		ip_hub_broadcasts = NULL;
+		ip_hubs_count = 0;
+	}
+#endif // ifdef IP_USE_HUB_BROADCASTS
+
+#ifdef IP_USE_HUB_MAILBOXES
+	void ip_init_hub_mailboxes()
+	{
+		// Not every version keeps the in-neighbours, so the in-degrees are counted from the out-neighbours.
+		IP_NEIGHBOUR_COUNT_TYPE* in_degrees = (IP_NEIGHBOUR_COUNT_TYPE*)ip_safe_malloc(sizeof(IP_NEIGHBOUR_COUNT_TYPE) * ip_get_vertices_count());
+		for(size_t i = 0; i < ip_get_vertices_count(); i++)
+		{
+			in_degrees[i] = 0;
+		}
+		for(size_t i = 0; i < ip_get_vertices_count(); i++)
+		{
+			struct ip_vertex_t* v = ip_get_vertex_by_location(i);
+			for(IP_NEIGHBOUR_COUNT_TYPE j = 0; j < v->out_neighbour_count; j++)
+			{
+				in_degrees[ip_get_vertex_by_id(v->out_neighbours[j]) - ip_get_vertex_by_location(0)]++;
+			}
+		}
+
+		size_t bitmap_words_count = (ip_get_vertices_count() + 63) / 64;
+		ip_hub_mailbox_bitmap = (uint64_t*)ip_safe_malloc(sizeof(uint64_t) * bitmap_words_count);
+		for(size_t i = 0; i < bitmap_words_count; i++)
+		{
+			ip_hub_mailbox_bitmap[i] = 0;
+		}
+		ip_hub_mailboxes_count = 0;
+		for(size_t i = 0; i < ip_get_vertices_count(); i++)
+		{
+			if(in_degrees[i] >= IP_HUB_IN_DEGREE_THRESHOLD)
+			{
+				ip_hub_mailbox_bitmap[i / 64] |= ((uint64_t)1) << (i % 64);
+				ip_hub_mailboxes_count++;
+			}
+		}
+		printf("HubMailboxCount:%zu\n", ip_hub_mailboxes_count);
+
+		// Locations are visited in increasing order, and so are the identifiers.
+		ip_hub_mailbox_ids = (IP_VERTEX_ID_TYPE*)ip_safe_malloc(sizeof(IP_VERTEX_ID_TYPE) * (ip_hub_mailboxes_count > 0 ? ip_hub_mailboxes_count : 1));
+		size_t hub = 0;
+		for(size_t i = 0; i < ip_get_vertices_count(); i++)
+		{
+			if(in_degrees[i] >= IP_HUB_IN_DEGREE_THRESHOLD)
+			{
+				ip_hub_mailbox_ids[hub] = ip_get_vertex_by_location(i)->id;
+				hub++;
+			}
+		}
+		ip_safe_free(in_degrees);
+
+		// Every thread has its partial mailboxes on cache lines of its own.
+		ip_all_hub_mailboxes = (struct ip_hub_mailbox_t**)ip_safe_malloc(sizeof(struct ip_hub_mailbox_t*) * ip_thread_count);
+		for(int i = 0; i < ip_thread_count; i++)
+		{
+			ip_all_hub_mailboxes[i] = (struct ip_hub_mailbox_t*)ip_safe_aligned_malloc(IP_CACHE_LINE_SIZE, sizeof(struct ip_hub_mailbox_t) * (ip_hub_mailboxes_count > 0 ? ip_hub_mailboxes_count : 1));
+			for(size_t j = 0; j < ip_hub_mailboxes_count; j++)
+			{
+				ip_all_hub_mailboxes[i][j].full = false;
+			}
+		}
+		atomic_init(&ip_hub_mailboxes_filled, false);
+	}
+
+	bool ip_has_hub_mailboxes(IP_VERTEX_ID_TYPE id)
+	{
+		size_t location = ip_get_vertex_by_id(id) - ip_get_vertex_by_location(0);
+		return (ip_hub_mailbox_bitmap[location / 64] >> (location % 64)) & 1;
+	}
+
+	void ip_deliver_to_hub_mailbox(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
+	{
+		size_t first = 0;
+		size_t last = ip_hub_mailboxes_count - 1;
+		while(first < last)
+		{
+			size_t middle = first + (last - first) / 2;
+			if(ip_hub_mailbox_ids[middle] < id)
+			{
+				first = middle + 1;
+			}
+			else
+			{
+				last = middle;
+			}
+		}
+		struct ip_hub_mailbox_t* partial = &ip_all_hub_mailboxes[ip_my_thread_num][first];
+		if(partial->full)
+		{
+			ip_combine(&partial->message, message);
+		}
+		else
+		{
+			partial->message = message;
+			partial->full = true;
+			// Once raised, the flag is only read until the end of the superstep, so there is no need to lock its cache line again.
+			if(!atomic_load_explicit(&ip_hub_mailboxes_filled, memory_order_relaxed))
+			{
+				atomic_store_explicit(&ip_hub_mailboxes_filled, true, memory_order_relaxed);
+			}
+		}
+	}
+
+	void ip_combine_hub_mailboxes_of(size_t hub)
+	{
+		bool full = false;
+		IP_MESSAGE_TYPE message;
+		for(int i = 0; i < ip_thread_count; i++)
+		{
+			struct ip_hub_mailbox_t* partial = &ip_all_hub_mailboxes[i][hub];
+			if(partial->full)
+			{
+				if(full)
+				{
+					ip_combine(&message, partial->message);
+				}
+				else
+				{
+					message = partial->message;
+					full = true;
+				}
+				partial->full = false;
+			}
+		}
+		if(full)
+		{
+			ip_deliver_binned_message(ip_hub_mailbox_ids[hub], message);
+		}
+	}
+
+	void ip_combine_hub_mailboxes()
+	{
+		// Partial mailboxes are only written before the barrier ending the phase that sends messages, so all threads take the same decision.
+		if(!atomic_load_explicit(&ip_hub_mailboxes_filled, memory_order_relaxed))
+		{
+			return;
+		}
+		#pragma omp for schedule(static)
+		for(size_t i = 0; i < ip_hub_mailboxes_count; i++)
+		{
+			ip_combine_hub_mailboxes_of(i);
+		}
+		// Nobody writes a partial mailbox until the barrier ending the next compute phase.
+		if(ip_my_thread_num == 0)
+		{
+			atomic_store_explicit(&ip_hub_mailboxes_filled, false, memory_order_relaxed);
+		}
+	}
+
+	void ip_combine_hub_mailboxes_alone()
+	{
+		if(atomic_load_explicit(&ip_hub_mailboxes_filled, memory_order_relaxed))
+		{
+			for(size_t i = 0; i < ip_hub_mailboxes_count; i++)
+			{
+				ip_combine_hub_mailboxes_of(i);
+			}
+			atomic_store_explicit(&ip_hub_mailboxes_filled, false, memory_order_relaxed);
+		}
+	}
+
+	void ip_free_hub_mailboxes()
+	{
+		for(int i = 0; i < ip_thread_count; i++)
+		{
+			ip_safe_free(ip_all_hub_mailboxes[i]);
+		}
+		ip_safe_free(ip_all_hub_mailboxes);
+		ip_all_hub_mailboxes = NULL;
+		ip_safe_free(ip_hub_mailbox_ids);
+		ip_hub_mailbox_ids = NULL;
+		ip_safe_free(ip_hub_mailbox_bitmap);
+		ip_hub_mailbox_bitmap = NULL;
+		ip_hub_mailboxes_count = 0;
+	}
+#endif // ifdef IP_USE_HUB_MAILBOXES
+
+double ip_get_aggregator_identity(enum ip_aggregator_operation_t operation)
+{
+	switch(operation)
+	{
+		case IP_AGGREGATOR_MIN:
+			return INFINITY;
+		case IP_AGGREGATOR_MAX:
+			return -INFINITY;
+		default:
+			return 0.0;
+	}
+}
+
+size_t ip_register_aggregator(enum ip_aggregator_operation_t operation)
+{
+	if(ip_aggregators_count == IP_MAX_AGGREGATORS)
+	{
+		printf("Cannot register more than %d aggregators, please increase IP_MAX_AGGREGATORS.\n", IP_MAX_AGGREGATORS);
+		exit(-1);
+	}
+
+	size_t aggregator = ip_aggregators_count;
+	ip_aggregators_count++;
+	ip_aggregator_operations[aggregator] = operation;
+	ip_aggregator_values[aggregator] = ip_get_aggregator_identity(operation);
+	for(int i = 0; i < ip_thread_count; i++)
+	{
+		ip_all_aggregator_partials[i].values[aggregator] = ip_aggregator_values[aggregator];
+	}
+	return aggregator;
+}
+
+void ip_aggregate(size_t aggregator, double value)
+{
+	double* partial = &ip_all_aggregator_partials[ip_my_thread_num].values[aggregator];
+	switch(ip_aggregator_operations[aggregator])
+	{
+		case IP_AGGREGATOR_SUM:
+			*partial += value;
+			break;
+		case IP_AGGREGATOR_MIN:
+			if(value < *partial)
+			{
+				*partial = value;
+			}
+			break;
+		case IP_AGGREGATOR_MAX:
+			if(value > *partial)
+			{
+				*partial = value;
+			}
+			break;
+	}
+}
+
+double ip_get_aggregated_value(size_t aggregator)
+{
+	return ip_aggregator_values[aggregator];
+}
+
+void ip_reduce_aggregators()
+{
+	for(size_t i = 0; i < ip_aggregators_count; i++)
+	{
+		double identity = ip_get_aggregator_identity(ip_aggregator_operations[i]);
+		ip_aggregator_values[i] = identity;
+		for(int j = 0; j < ip_thread_count; j++)
+		{
+			double partial = ip_all_aggregator_partials[j].values[i];
+			switch(ip_aggregator_operations[i])
+			{
+				case IP_AGGREGATOR_SUM:
+					ip_aggregator_values[i] += partial;
+					break;
+				case IP_AGGREGATOR_MIN:
+					if(partial < ip_aggregator_values[i])
+					{
+						ip_aggregator_values[i] = partial;
+					}
+					break;
+				case IP_AGGREGATOR_MAX:
+					if(partial > ip_aggregator_values[i])
+					{
+						ip_aggregator_values[i] = partial;
+					}
+					break;
+			}
+			ip_all_aggregator_partials[j].values[i] = identity;
+		}
+	}
+}
+
+#ifdef IP_NEEDS_REMOTE_VALUES
+	IP_VALUE_TYPE ip_get_value_of(IP_VERTEX_ID_TYPE id)
+	{
+		return ip_committed_values[ip_get_vertex_by_id(id) - ip_get_vertex_by_location(0)];
+	}
+
+	void ip_commit_values()
+	{
+		#pragma omp for schedule(static)
+		for(size_t i = 0; i < ip_get_vertices_count(); i++)
+		{
+			ip_committed_values[i] = ip_get_vertex_by_location(i)->value;
+		}
+	}
+#endif // ifdef IP_NEEDS_REMOTE_VALUES
+
 void ip_dump(FILE* f)
 {
 	double timer_dump_start = omp_get_wtime();
@@ -125,6 +882,18 @@ void* ip_safe_malloc(size_t size_to_malloc)
 	return ptr;
 }
 
+void* ip_safe_aligned_malloc(size_t alignment, size_t size_to_malloc)
+{
+	size_to_malloc = (size_to_malloc + alignment - 1) / alignment * alignment;
+	void* ptr = aligned_alloc(alignment, size_to_malloc);
+	if(ptr == NULL)
+	{
+		printf("Failed to allocate %zu bytes aligned on %zu bytes.\n", size_to_malloc, alignment);
+		exit(-1);
+	}
+	return ptr;
+}
+
 void* ip_safe_realloc(void* ptr, size_t size_to_realloc)
 {
 	ptr = realloc(ptr, size_to_realloc);
@@ -185,6 +954,17 @@ void tmp_extract_runtime_schedule(const char* schedule, int chunk_size)
 		omp_set_schedule(omp_sched_dynamic, chunk_size);
 		printf("Runtime schedule set to dynamic(%d).\n", chunk_size);
 	}
+	else if(strcmp(schedule, "edge_stealing") == 0)
+	{
+		// Loops that are not vertex processing keep a dynamic schedule.
+		omp_set_schedule(omp_sched_dynamic, 0);
+		ip_use_edge_stealing = true;
+		if(chunk_size > 0)
+		{
+			ip_edge_stealing_chunks_per_thread = chunk_size;
+		}
+		printf("Runtime schedule set to edge_stealing(%zu chunks per thread).\n", ip_edge_stealing_chunks_per_thread);
+	}
 	else
 	{
 		printf("The schedule %s is unknown.\n", schedule);
@@ -236,11 +1016,31 @@ void ip_init(const char* file_path, int number_of_threads, const char* schedule,
 
 	// Load the graph
 	ip_load_graph(file_path, directed, weighted);
+	#ifdef IP_USE_HUB_BROADCASTS
+		ip_init_hub_broadcasts();
+	#endif // ifdef IP_USE_HUB_BROADCASTS
+	#ifdef IP_USE_HUB_MAILBOXES
+		ip_init_hub_mailboxes();
+	#endif // ifdef IP_USE_HUB_MAILBOXES
 		
 	timer_init_stop = omp_get_wtime();
 	printf("InitialisationTime:%f\n", timer_init_stop - timer_init_start);
 }
 
+void ip_init_thread_contexts()
+{
+	ip_all_thread_contexts = (struct ip_thread_context_t*)ip_safe_aligned_malloc(IP_CACHE_LINE_SIZE, sizeof(struct ip_thread_context_t) * ip_thread_count);
+	ip_all_aggregator_partials = (struct ip_aggregator_partials_t*)ip_safe_aligned_malloc(IP_CACHE_LINE_SIZE, sizeof(struct ip_aggregator_partials_t) * ip_thread_count);
+	#ifdef IP_USE_SPIN_BARRIER
+		ip_init_spin_barrier();
+	#endif // ifdef IP_USE_SPIN_BARRIER
+	#pragma omp parallel default(none) shared(ip_all_thread_contexts)
+	{
+		ip_my_thread_num = omp_get_thread_num();
+		ip_init_thread_context(&ip_all_thread_contexts[ip_my_thread_num]);
+	}
+}
+
 void tmp_load_graph_config(const char* file_path)
 {
 	char config_file_extension[] = ".config";
@@ -266,6 +1066,18 @@ void tmp_load_graph_config(const char* file_path)
 	printf("\t\t- %zu vertices\n\t\t- %zu edges\n", ip_get_vertices_count(), ip_get_edges_count());
 }
 
+void ip_get_vertex_block(int thread_num, size_t* first, size_t* last)
+{
+	size_t block_size = ip_get_vertices_count() / ip_thread_count;
+	*first = block_size * thread_num;
+	*last = *first + block_size;
+	// The last thread also takes the remainder.
+	if(thread_num == ip_thread_count - 1)
+	{
+		*last = ip_get_vertices_count();
+	}
+}
+
 void tmp_init_vertices()
 {
 	printf("\t- Initialising vertices\n");
@@ -275,13 +1087,11 @@ void tmp_init_vertices()
 	IP_VERTEX_ID_TYPE vertex_total = 0;
 	#pragma omp parallel default(none) shared(ip_all_vertices, ip_vertices_count, ip_thread_count) reduction(+:vertex_total)
 	{
-		bool i_am_last_thread = omp_get_thread_num() == ip_thread_count - 1;
-		IP_VERTEX_ID_TYPE vertex_chunk = (ip_get_vertices_count() - (ip_get_vertices_count() % ip_thread_count)) / ip_thread_count;
-		IP_VERTEX_ID_TYPE vertex_start = vertex_chunk * omp_get_thread_num();
-		if(i_am_last_thread)
-		{
-			vertex_chunk += ip_get_vertices_count() % ip_thread_count;
-		} // Must be AFTER vertex_start
+		size_t block_first;
+		size_t block_last;
+		ip_get_vertex_block(omp_get_thread_num(), &block_first, &block_last);
+		IP_VERTEX_ID_TYPE vertex_start = block_first;
+		IP_VERTEX_ID_TYPE vertex_chunk = block_last - block_first;
 		vertex_total += vertex_chunk;
 		printf("\t\t| %9d | %12u | %12u | %12u | %9.5f |\n", omp_get_thread_num(), vertex_start, vertex_start + vertex_chunk - 1, vertex_chunk, ((float)vertex_chunk) / ((float)ip_get_vertices_count()) * 100.0f);
 		ip_init_vertex_range(vertex_start, vertex_start + vertex_chunk - 1);
@@ -513,9 +1323,20 @@ void ip_load_graph(const char* file_path, bool directed, bool weighted)
 	// Allocate vertices
 	ip_active_vertices = ip_get_vertices_count();
 	ip_all_vertices = (struct ip_vertex_t*)ip_safe_malloc(sizeof(struct ip_vertex_t) * ip_get_vertices_count());
+	#ifdef IP_NEEDS_REMOTE_VALUES
+		ip_committed_values = (IP_VALUE_TYPE*)ip_safe_malloc(sizeof(IP_VALUE_TYPE) * ip_get_vertices_count());
+	#endif // ifdef IP_NEEDS_REMOTE_VALUES
 	
 	// The number of vertices and edges are known, the vertices are allocated so tell whatever version used to launch its own initialisation.
+	ip_init_thread_contexts();
 	ip_init_specific();
+	#if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_SIDE_MAILBOXES)
+		ip_init_bins();
+	#endif // if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_SIDE_MAILBOXES)
+	if(ip_use_edge_stealing)
+	{
+		ip_init_edge_stealing();
+	}
 
 	// Initialise vertices
 	tmp_init_vertices();
@@ -37,8 +37,153 @@
 	#define IP_NEEDS_IN_NEIGHBOUR_COUNT
 #endif // #if defined(IP_NEEDS_IN_NEIGHBOUR_IDS) && !defined(IP_NEEDS_IN_NEIGHBOUR_COUNT)
 
+#if defined(IP_USE_PRIORITY_BUCKETS) && !defined(IP_USE_ASYNCHRONOUS)
+	// Priority buckets order the worklists of the asynchronous version.
+	#define IP_USE_ASYNCHRONOUS
+#endif // if defined(IP_USE_PRIORITY_BUCKETS) && !defined(IP_USE_ASYNCHRONOUS)
+
+#ifdef IP_USE_PROPAGATION_BLOCKING
+	#if defined(IP_USE_SINGLE_BROADCAST) && !defined(IP_USE_HYBRID)
+		#error Single broadcast versions never write into the mailbox of another vertex, there is nothing to bin; IP_USE_PROPAGATION_BLOCKING and IP_USE_SINGLE_BROADCAST cannot be used together.
+	#elif defined(IP_WITHOUT_COMBINER)
+		#error The version without combiner already sorts messages by recipient between supersteps, IP_USE_PROPAGATION_BLOCKING and IP_WITHOUT_COMBINER cannot be used together.
+	#elif defined(IP_USE_ASYNCHRONOUS)
+		#error The asynchronous version must see a message as soon as it is sent to schedule its recipient, IP_USE_PROPAGATION_BLOCKING and IP_USE_ASYNCHRONOUS (implied by IP_USE_PRIORITY_BUCKETS) cannot be used together.
+	#elif defined(IP_USE_BLOCK_CENTRIC)
+		#error The block-centric version delivers most messages within the block of the sender without atomic operations already, IP_USE_PROPAGATION_BLOCKING and IP_USE_BLOCK_CENTRIC cannot be used together.
+	#endif
+#endif // ifdef IP_USE_PROPAGATION_BLOCKING
+
+#ifdef IP_USE_SPIN_BARRIER
+	#if !defined(IP_USE_SPREAD)
+		#error Only the supersteps of the spreading version are built around spinning barriers, IP_USE_SPIN_BARRIER requires IP_USE_SPREAD.
+	#elif defined(IP_WITHOUT_COMBINER)
+		#error Only the supersteps of the spreading version are built around spinning barriers, IP_USE_SPIN_BARRIER and IP_WITHOUT_COMBINER cannot be used together.
+	#elif defined(IP_USE_SINGLE_BROADCAST)
+		#error Only the supersteps of the spreading version are built around spinning barriers, IP_USE_SPIN_BARRIER and IP_USE_SINGLE_BROADCAST cannot be used together.
+	#elif defined(IP_USE_HYBRID)
+		#error Only the supersteps of the spreading version are built around spinning barriers, IP_USE_SPIN_BARRIER and IP_USE_HYBRID cannot be used together.
+	#elif defined(IP_USE_BLOCK_CENTRIC)
+		#error Only the supersteps of the spreading version are built around spinning barriers, IP_USE_SPIN_BARRIER and IP_USE_BLOCK_CENTRIC cannot be used together.
+	#elif defined(IP_USE_ASYNCHRONOUS)
+		#error Only the supersteps of the spreading version are built around spinning barriers, IP_USE_SPIN_BARRIER and IP_USE_ASYNCHRONOUS (implied by IP_USE_PRIORITY_BUCKETS) cannot be used together.
+	#endif
+#endif // ifdef IP_USE_SPIN_BARRIER
+
+#ifdef IP_USE_ADAPTIVE_THREADS
+	#if !defined(IP_USE_SPREAD)
+		#error Only the spreading version adapts its number of threads, IP_USE_ADAPTIVE_THREADS requires IP_USE_SPREAD.
+	#elif defined(IP_WITHOUT_COMBINER)
+		#error Only the spreading version adapts its number of threads, IP_USE_ADAPTIVE_THREADS and IP_WITHOUT_COMBINER cannot be used together.
+	#elif defined(IP_USE_SINGLE_BROADCAST)
+		#error Only the spreading version adapts its number of threads, IP_USE_ADAPTIVE_THREADS and IP_USE_SINGLE_BROADCAST cannot be used together.
+	#elif defined(IP_USE_HYBRID)
+		#error Only the spreading version adapts its number of threads, IP_USE_ADAPTIVE_THREADS and IP_USE_HYBRID cannot be used together.
+	#elif defined(IP_USE_BLOCK_CENTRIC)
+		#error Only the spreading version adapts its number of threads, IP_USE_ADAPTIVE_THREADS and IP_USE_BLOCK_CENTRIC cannot be used together.
+	#elif defined(IP_USE_ASYNCHRONOUS)
+		#error Only the spreading version adapts its number of threads, IP_USE_ADAPTIVE_THREADS and IP_USE_ASYNCHRONOUS (implied by IP_USE_PRIORITY_BUCKETS) cannot be used together.
+	#elif defined(IP_USE_SPIN_BARRIER)
+		#error Spinning barriers are cheap enough for any number of threads, IP_USE_ADAPTIVE_THREADS and IP_USE_SPIN_BARRIER cannot be used together.
+	#endif
+#endif // ifdef IP_USE_ADAPTIVE_THREADS
+
+#ifdef IP_USE_SORTED_FRONTIER
+	#if !defined(IP_USE_SPREAD)
+		#error Only the spreading version has a merge phase to sort the frontier in, IP_USE_SORTED_FRONTIER requires IP_USE_SPREAD.
+	#elif defined(IP_WITHOUT_COMBINER)
+		#error Only the spreading version has a merge phase to sort the frontier in, IP_USE_SORTED_FRONTIER and IP_WITHOUT_COMBINER cannot be used together.
+	#elif defined(IP_USE_SINGLE_BROADCAST)
+		#error Only the spreading version has a merge phase to sort the frontier in, IP_USE_SORTED_FRONTIER and IP_USE_SINGLE_BROADCAST cannot be used together.
+	#elif defined(IP_USE_HYBRID)
+		#error Only the spreading version has a merge phase to sort the frontier in, IP_USE_SORTED_FRONTIER and IP_USE_HYBRID cannot be used together.
+	#elif defined(IP_USE_BLOCK_CENTRIC)
+		#error Only the spreading version has a merge phase to sort the frontier in, IP_USE_SORTED_FRONTIER and IP_USE_BLOCK_CENTRIC cannot be used together.
+	#elif defined(IP_USE_ASYNCHRONOUS)
+		#error Only the spreading version has a merge phase to sort the frontier in, IP_USE_SORTED_FRONTIER and IP_USE_ASYNCHRONOUS (implied by IP_USE_PRIORITY_BUCKETS) cannot be used together.
+	#elif defined(IP_USE_SPIN_BARRIER)
+		#error The spinning version fuses the merge phase with the mailbox update, IP_USE_SORTED_FRONTIER and IP_USE_SPIN_BARRIER cannot be used together.
+	#endif
+#endif // ifdef IP_USE_SORTED_FRONTIER
+
+#ifdef IP_USE_DENSE_FRONTIER
+	#if !defined(IP_USE_SPREAD)
+		#error Only the spreading version switches its frontier to a bitmap, IP_USE_DENSE_FRONTIER requires IP_USE_SPREAD.
+	#elif defined(IP_WITHOUT_COMBINER)
+		#error Only the spreading version switches its frontier to a bitmap, IP_USE_DENSE_FRONTIER and IP_WITHOUT_COMBINER cannot be used together.
+	#elif defined(IP_USE_SINGLE_BROADCAST)
+		#error Only the spreading version switches its frontier to a bitmap, IP_USE_DENSE_FRONTIER and IP_USE_SINGLE_BROADCAST cannot be used together.
+	#elif defined(IP_USE_HYBRID)
+		#error Only the spreading version switches its frontier to a bitmap, IP_USE_DENSE_FRONTIER and IP_USE_HYBRID cannot be used together.
+	#elif defined(IP_USE_BLOCK_CENTRIC)
+		#error Only the spreading version switches its frontier to a bitmap, IP_USE_DENSE_FRONTIER and IP_USE_BLOCK_CENTRIC cannot be used together.
+	#elif defined(IP_USE_ASYNCHRONOUS)
+		#error Only the spreading version switches its frontier to a bitmap, IP_USE_DENSE_FRONTIER and IP_USE_ASYNCHRONOUS (implied by IP_USE_PRIORITY_BUCKETS) cannot be used together.
+	#elif defined(IP_USE_SPIN_BARRIER)
+		#error The spinning version fuses the phases that scan the bitmap, IP_USE_DENSE_FRONTIER and IP_USE_SPIN_BARRIER cannot be used together.
+	#elif defined(IP_USE_ADAPTIVE_THREADS)
+		#error The bitmap frontier is always scanned by all threads, IP_USE_DENSE_FRONTIER and IP_USE_ADAPTIVE_THREADS cannot be used together.
+	#endif
+#endif // ifdef IP_USE_DENSE_FRONTIER
+
+#ifdef IP_USE_SPARSE_PULL
+	#if !defined(IP_USE_SINGLE_BROADCAST)
+		#error Only the single broadcast version pulls from all vertices at every superstep, IP_USE_SPARSE_PULL requires IP_USE_SINGLE_BROADCAST.
+	#elif defined(IP_WITHOUT_COMBINER)
+		#error Only the single broadcast version pulls from all vertices at every superstep, IP_USE_SPARSE_PULL and IP_WITHOUT_COMBINER cannot be used together.
+	#elif defined(IP_USE_SPREAD)
+		#error The single broadcast spreading version pulls from its targets only already, IP_USE_SPARSE_PULL and IP_USE_SPREAD cannot be used together.
+	#elif defined(IP_USE_HYBRID)
+		#error Only the single broadcast version pulls from all vertices at every superstep, IP_USE_SPARSE_PULL and IP_USE_HYBRID cannot be used together.
+	#elif defined(IP_USE_BLOCK_CENTRIC)
+		#error Only the single broadcast version pulls from all vertices at every superstep, IP_USE_SPARSE_PULL and IP_USE_BLOCK_CENTRIC cannot be used together.
+	#elif defined(IP_USE_ASYNCHRONOUS)
+		#error Only the single broadcast version pulls from all vertices at every superstep, IP_USE_SPARSE_PULL and IP_USE_ASYNCHRONOUS (implied by IP_USE_PRIORITY_BUCKETS) cannot be used together.
+	#endif
+#endif // ifdef IP_USE_SPARSE_PULL
+
+#ifdef IP_USE_SIDE_MAILBOXES
+	#if !defined(IP_USE_SINGLE_BROADCAST)
+		#error Only the single broadcast versions have no mailbox that other vertices write into, IP_USE_SIDE_MAILBOXES requires IP_USE_SINGLE_BROADCAST.
+	#elif defined(IP_WITHOUT_COMBINER)
+		#error Only the single broadcast versions have no mailbox that other vertices write into, IP_USE_SIDE_MAILBOXES and IP_WITHOUT_COMBINER cannot be used together.
+	#elif defined(IP_USE_HYBRID)
+		#error The hybrid version accepts ip_send_message already, IP_USE_SIDE_MAILBOXES and IP_USE_HYBRID cannot be used together.
+	#elif defined(IP_USE_BLOCK_CENTRIC)
+		#error Only the single broadcast versions have no mailbox that other vertices write into, IP_USE_SIDE_MAILBOXES and IP_USE_BLOCK_CENTRIC cannot be used together.
+	#elif defined(IP_USE_ASYNCHRONOUS)
+		#error Only the single broadcast versions have no mailbox that other vertices write into, IP_USE_SIDE_MAILBOXES and IP_USE_ASYNCHRONOUS (implied by IP_USE_PRIORITY_BUCKETS) cannot be used together.
+	#endif
+#endif // ifdef IP_USE_SIDE_MAILBOXES
+
+#ifdef IP_USE_HUB_BROADCASTS
+	#if defined(IP_USE_SINGLE_BROADCAST) && !defined(IP_USE_HYBRID)
+		#error Single broadcast versions do not loop over out-neighbours, IP_USE_HUB_BROADCASTS and IP_USE_SINGLE_BROADCAST cannot be used together.
+	#elif defined(IP_USE_BLOCK_CENTRIC)
+		#error The block-centric version has no phase after computing in which threads could share hub broadcasts, IP_USE_HUB_BROADCASTS and IP_USE_BLOCK_CENTRIC cannot be used together.
+	#elif defined(IP_USE_ASYNCHRONOUS)
+		#error The asynchronous version has no phase after computing in which threads could share hub broadcasts, IP_USE_HUB_BROADCASTS and IP_USE_ASYNCHRONOUS (implied by IP_USE_PRIORITY_BUCKETS) cannot be used together.
+	#endif
+#endif // ifdef IP_USE_HUB_BROADCASTS
+
+#ifdef IP_USE_HUB_MAILBOXES
+	#if defined(IP_WITHOUT_COMBINER)
+		#error The version without combiner has no mailbox to split, IP_USE_HUB_MAILBOXES and IP_WITHOUT_COMBINER cannot be used together.
+	#elif defined(IP_USE_SINGLE_BROADCAST) && !defined(IP_USE_HYBRID)
+		#error Single broadcast versions have no mailbox that other vertices write into, IP_USE_HUB_MAILBOXES and IP_USE_SINGLE_BROADCAST cannot be used together.
+	#elif defined(IP_USE_BLOCK_CENTRIC)
+		#error The block-centric version has no phase after computing in which partial mailboxes could be combined, IP_USE_HUB_MAILBOXES and IP_USE_BLOCK_CENTRIC cannot be used together.
+	#elif defined(IP_USE_ASYNCHRONOUS)
+		#error The asynchronous version has no phase after computing in which partial mailboxes could be combined, IP_USE_HUB_MAILBOXES and IP_USE_ASYNCHRONOUS (implied by IP_USE_PRIORITY_BUCKETS) cannot be used together.
+	#elif defined(IP_USE_PROPAGATION_BLOCKING)
+		#error Propagation blocking already delivers every message without atomic operations, IP_USE_HUB_MAILBOXES and IP_USE_PROPAGATION_BLOCKING cannot be used together.
+	#endif
+#endif // ifdef IP_USE_HUB_MAILBOXES
+
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <time.h>
 
 /// This variable contains the current superstep number. It is 0-indexed.
@@ -55,6 +200,33 @@ struct ip_vertex_t;
 struct ip_vertex_t* ip_all_vertices = NULL;
 /// The number of threads available for processing.
 int ip_thread_count;
+/// The identifier of the calling thread in the OpenMP team processing the supersteps.
+int ip_my_thread_num;
+#pragma omp threadprivate(ip_my_thread_num)
+/// The size of a cache line in bytes, used to keep the data of different threads apart.
+#define IP_CACHE_LINE_SIZE 64
+/// Forward declaration of the per-thread context structure, defined by each version.
+struct ip_thread_context_t;
+/// This variable contains the context of every thread, each starting on its own cache line.
+struct ip_thread_context_t* ip_all_thread_contexts = NULL;
+/**
+ * @brief The states a mailbox goes through during a superstep.
+ * @details When the user defines IP_COMBINER_IDENTITY, the mailbox always
+ * contains a valid message so only IP_MAILBOX_EMPTY and IP_MAILBOX_FULL are
+ * used. Otherwise, the first sender moves the mailbox to IP_MAILBOX_WRITING
+ * while it stores its message.
+ **/
+enum ip_mailbox_state_t
+{
+	/// The mailbox has not received any message yet.
+	IP_MAILBOX_EMPTY = 0,
+	/// The first message is being stored in the mailbox.
+	IP_MAILBOX_WRITING,
+	/// The mailbox contains a message.
+	IP_MAILBOX_FULL
+};
+/// The type of the flag holding the state of a mailbox.
+typedef atomic_uchar IP_MAILBOX_FLAG_TYPE;
 
 // Functions to access global variables.
 /**
@@ -179,6 +351,558 @@ extern void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last
  **/
 void ip_load_graph(const char* file_path, bool directed, bool weighted);
 
+/*********************
+ * MAILBOX FUNCTIONS *
+ *********************/
+// The version without combiner has no mailbox, messages are sorted into an inbox instead.
+#ifndef IP_WITHOUT_COMBINER
+	#if defined(IP_COMBINER_MIN) + defined(IP_COMBINER_MAX) + defined(IP_COMBINER_SUM) + defined(IP_COMBINER_FLOATING_SUM) > 1
+		#error At most one of IP_COMBINER_MIN, IP_COMBINER_MAX, IP_COMBINER_SUM and IP_COMBINER_FLOATING_SUM can be defined.
+	#endif // if defined(IP_COMBINER_MIN) + ...
+	#ifdef IP_COMBINER_SUM
+		// Floating-point messages cannot be added with a fetch-and-add, they need the compare-and-swap loop of IP_COMBINER_FLOATING_SUM.
+		_Static_assert(_Generic((IP_MESSAGE_TYPE)0, float: false, double: false, long double: false, default: true), "IP_COMBINER_SUM requires integer messages, use IP_COMBINER_FLOATING_SUM instead.");
+	#endif // ifdef IP_COMBINER_SUM
+	#ifdef IP_COMPOSITE_MESSAGES
+		/**
+		 * Indicates whether messages can be combined with a compare-and-swap. It
+		 * requires a size of 1, 2, 4 or 8 bytes and an alignment of that size.
+		 * 16-byte messages would need a double-width compare-and-swap, which
+		 * compilers leave to libatomic, so they use the locks instead.
+		 **/
+		#define IP_MESSAGE_CAS_ABLE (sizeof(IP_MESSAGE_TYPE) <= 8 && (sizeof(IP_MESSAGE_TYPE) & (sizeof(IP_MESSAGE_TYPE) - 1)) == 0 && _Alignof(IP_MESSAGE_TYPE) >= sizeof(IP_MESSAGE_TYPE))
+		#ifndef IP_MESSAGE_LOCK_STRIPES
+			/// The number of locks protecting the mailboxes when messages cannot be combined with a compare-and-swap.
+			#define IP_MESSAGE_LOCK_STRIPES 1024
+		#endif // ifndef IP_MESSAGE_LOCK_STRIPES
+		/// A spinlock protecting all the mailboxes mapped to it.
+		struct ip_message_lock_t
+		{
+			/// Indicates whether a thread holds the lock.
+			atomic_bool locked;
+			/// Keeps different locks on different cache lines.
+			char padding[IP_CACHE_LINE_SIZE - sizeof(atomic_bool)];
+		};
+		/// The locks protecting the mailboxes of messages that cannot be combined with a compare-and-swap; a mailbox is mapped to a lock by its address.
+		struct ip_message_lock_t ip_message_locks[IP_MESSAGE_LOCK_STRIPES];
+		/**
+		 * @brief This function acquires the lock that the mailbox \p mailbox
+		 * maps to.
+		 * @param[in] mailbox The mailbox to protect.
+		 * @return The lock acquired.
+		 **/
+		struct ip_message_lock_t* ip_lock_mailbox(IP_MESSAGE_TYPE* mailbox);
+		/**
+		 * @brief This function releases the lock \p lock.
+		 * @param[inout] lock The lock acquired with ip_lock_mailbox().
+		 **/
+		void ip_unlock_mailbox(struct ip_message_lock_t* lock);
+	#endif // ifdef IP_COMPOSITE_MESSAGES
+	/**
+	 * @brief This function atomically combines the message \p message into the
+	 * mailbox \p mailbox.
+	 * @details When IP_COMPOSITE_MESSAGES is defined, messages are compared
+	 * bytewise so that structures can be used. Those that are not
+	 * IP_MESSAGE_CAS_ABLE are combined under the lock their mailbox maps to.
+	 * Otherwise, if the application declares its combiner with IP_COMBINER_MIN
+	 * or IP_COMBINER_MAX, the message is written with a compare-and-swap only
+	 * while it improves on the mailbox, without calling ip_combine(). With
+	 * IP_COMBINER_SUM, the message is added with a single fetch-and-add, and
+	 * with IP_COMBINER_FLOATING_SUM with a compare-and-swap loop doing the
+	 * addition itself.
+	 * @param[inout] mailbox The mailbox in which combine the message.
+	 * @param[in] message The message to combine.
+	 * @pre \p mailbox already contains a message.
+	 * @post \p mailbox contains the combination of its previous content and
+	 * \p message.
+	 * @retval true The content of the mailbox changed.
+	 * @retval false The message left the mailbox unchanged.
+	 **/
+	bool ip_cas(IP_MESSAGE_TYPE* mailbox, IP_MESSAGE_TYPE message);
+	/**
+	 * @brief This function delivers the message \p message into the mailbox
+	 * \p mailbox whose state is held by \p flag, without any lock.
+	 * @details If IP_COMBINER_IDENTITY is defined, every delivery is a single
+	 * compare-and-swap combination, and only the first one also flips the flag.
+	 * Otherwise, the first sender wins the flag with a compare-and-swap and stores
+	 * its message, while the other senders wait for that store before combining.
+	 * @param[inout] flag The state of the mailbox.
+	 * @param[inout] mailbox The mailbox in which deliver the message.
+	 * @param[in] message The message to deliver.
+	 * @retval true The mailbox was empty before this delivery.
+	 * @retval false The mailbox already had a message.
+	 **/
+	bool ip_deliver_message(IP_MAILBOX_FLAG_TYPE* flag, IP_MESSAGE_TYPE* mailbox, IP_MESSAGE_TYPE message);
+	/**
+	 * @brief This function empties the mailbox \p mailbox whose state is held by
+	 * \p flag so that it is ready for the next superstep.
+	 * @param[out] flag The state of the mailbox.
+	 * @param[out] mailbox The mailbox to empty.
+	 * @pre No thread is delivering messages into that mailbox.
+	 **/
+	void ip_empty_mailbox(IP_MAILBOX_FLAG_TYPE* flag, IP_MESSAGE_TYPE* mailbox);
+#endif // ifndef IP_WITHOUT_COMBINER
+
+/***************************
+ * EDGE STEALING SCHEDULER *
+ ***************************/
+/// Indicates whether vertex processing uses the edge stealing scheduler instead of the OpenMP runtime schedule.
+bool ip_use_edge_stealing = false;
+/// The number of chunks every thread receives at the beginning of a loop scheduled with edge stealing.
+size_t ip_edge_stealing_chunks_per_thread = 16;
+/// This structure holds the chunks that a thread has left to process.
+struct ip_chunk_deque_t
+{
+	/// The first chunk left in the upper 32 bits, one past the last chunk left in the lower 32 bits. Packing both lets the owner and the thieves compete on a single compare-and-swap.
+	_Atomic uint64_t head_and_tail;
+	/// Keeps the deques of different threads on different cache lines.
+	char padding[64 - sizeof(uint64_t)];
+};
+/// This structure holds the state of the edge stealing scheduler.
+struct ip_edge_stealing_t
+{
+	/// The number of items in the loop currently scheduled.
+	size_t items_count;
+	/// The capacity of workload_prefix.
+	size_t max_items_count;
+	/// Indicates whether the chunk bounds computed last cover all vertices, in which case they can be reused as is.
+	bool covers_all_vertices;
+	/// Indicates whether the loop being prepared reuses the chunk bounds computed last.
+	bool reuse_bounds;
+	/// The workload of the items before each item, items_count + 1 elements.
+	size_t* workload_prefix;
+	/// The workload of the items assigned to each thread to compute workload_prefix.
+	size_t* thread_workloads;
+	/// The first item of every chunk, followed by items_count.
+	size_t* chunk_bounds;
+	/// The deque of every thread.
+	struct ip_chunk_deque_t* deques;
+};
+/// The state of the edge stealing scheduler.
+struct ip_edge_stealing_t ip_edge_stealing;
+/**
+ * @brief This function allocates the structures of the edge stealing
+ * scheduler.
+ * @pre The number of threads is known.
+ **/
+void ip_init_edge_stealing();
+/**
+ * @brief This function splits a loop over vertices into chunks of similar
+ * workload and hands ip_edge_stealing_chunks_per_thread of them to each thread.
+ * @details The workload of a vertex is its number of out-neighbours plus one.
+ * When \p ids is NULL, the chunk bounds are computed once and reused by every
+ * later loop over all vertices. This function contains barriers and must
+ * therefore be called by all threads of the team.
+ * @param[in] ids The identifiers of the vertices to process, or NULL to
+ * process all vertices by location.
+ * @param[in] items_count The number of vertices to process.
+ * @post Every thread can get chunks with ip_get_next_chunk().
+ **/
+void ip_prepare_chunks(const IP_VERTEX_ID_TYPE* ids, size_t items_count);
+/**
+ * @brief This function gives the calling thread the next chunk to process.
+ * @details A thread takes the chunks from the front of its own deque first,
+ * then steals from the back of the deques of other threads.
+ * @param[out] first The first item of the chunk.
+ * @param[out] last One past the last item of the chunk.
+ * @retval true A chunk was found.
+ * @retval false All chunks of the loop have been taken.
+ **/
+bool ip_get_next_chunk(size_t* first, size_t* last);
+
+#if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_SIDE_MAILBOXES)
+	/**********************************
+	 * PROPAGATION BLOCKING FUNCTIONS *
+	 **********************************/
+	// The single broadcast versions use the bins as side mailboxes for the few messages sent to a given vertex.
+	#ifndef IP_PROPAGATION_BLOCKING_RANGE
+		/// The number of consecutive destination vertices covered by a bin; their mailboxes should fit in cache.
+		#define IP_PROPAGATION_BLOCKING_RANGE 32768
+	#endif // ifndef IP_PROPAGATION_BLOCKING_RANGE
+	/// A message waiting in a bin until its destination mailbox is updated.
+	struct ip_binned_message_t
+	{
+		/// The identifier of the recipient.
+		IP_VERTEX_ID_TYPE id;
+		/// The message to deliver.
+		IP_MESSAGE_TYPE message;
+	};
+	/// This structure holds the messages that a thread sent to a range of vertices.
+	struct ip_bin_t
+	{
+		/// The size of the memory buffer. It is used for reallocation purpose.
+		size_t max_size;
+		/// The number of messages currently stored.
+		size_t size;
+		/// The actual messages.
+		struct ip_binned_message_t* data;
+	};
+	/// The number of bins each thread has, that is, the number of destination ranges.
+	size_t ip_bins_per_thread = 0;
+	/// The bins of all threads; those of thread t start at t * ip_bins_per_thread.
+	struct ip_bin_t* ip_all_bins = NULL;
+	/**
+	 * @brief This function allocates the bins of every thread.
+	 * @pre The number of vertices is known.
+	 **/
+	void ip_init_bins();
+	/**
+	 * @brief This function stores the message \p message in the bin of the
+	 * calling thread covering the vertex \p id.
+	 * @details The message will reach the mailbox of the vertex \p id when
+	 * ip_apply_bins() is called.
+	 * @param[in] id The identifier of the recipient.
+	 * @param[in] message The message to send.
+	 **/
+	void ip_bin_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message);
+	/**
+	 * @brief This function delivers all binned messages and empties the bins.
+	 * @details Each range of destinations is processed by a single thread, which
+	 * goes through the corresponding bin of every thread and hands each message
+	 * to ip_deliver_binned_message(). This function contains an OpenMP for
+	 * construct and must therefore be called by all threads of the team.
+	 * @post All bins are empty.
+	 **/
+	void ip_apply_bins();
+#endif // if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_SIDE_MAILBOXES)
+
+#if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES)
+	/**
+	 * @brief This function delivers the message \p message into the mailbox
+	 * \p mailbox whose state is held by \p flag, knowing that no other thread
+	 * accesses that mailbox.
+	 * @param[inout] flag The state of the mailbox.
+	 * @param[inout] mailbox The mailbox in which deliver the message.
+	 * @param[in] message The message to deliver.
+	 * @retval true The mailbox was empty before this delivery.
+	 * @retval false The mailbox already had a message.
+	 **/
+	bool ip_deliver_message_exclusively(IP_MAILBOX_FLAG_TYPE* flag, IP_MESSAGE_TYPE* mailbox, IP_MESSAGE_TYPE message);
+#endif // if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES)
+
+#if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES) || defined(IP_USE_SIDE_MAILBOXES)
+	/**
+	 * @brief This function is implemented by underlying iPregel version to
+	 * deliver a binned message, or the combination of the partial mailboxes of a
+	 * hub, into the mailbox of vertex \p id.
+	 * @param[in] id The identifier of the recipient.
+	 * @param[in] message The message to deliver.
+	 * @pre The calling thread is the only one accessing the mailbox of vertex
+	 * \p id.
+	 **/
+	extern void ip_deliver_binned_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message);
+#endif // if defined(IP_USE_PROPAGATION_BLOCKING) || defined(IP_USE_HUB_MAILBOXES) || defined(IP_USE_SIDE_MAILBOXES)
+
+/****************
+ * SPIN BARRIER *
+ ****************/
+#ifdef IP_USE_SPIN_BARRIER
+	#include <sched.h> // sched_yield
+	#ifndef IP_SPIN_BARRIER_SPINS
+		/// The number of times a thread polls its flag before yielding its core, which only matters when there are more threads than cores.
+		#define IP_SPIN_BARRIER_SPINS 4096
+	#endif // ifndef IP_SPIN_BARRIER_SPINS
+	/// The maximum number of rounds of the dissemination barrier, enough for 2^32 threads.
+	#define IP_SPIN_BARRIER_MAX_ROUNDS 32
+	/// This structure holds the flags through which the partners of a thread tell it that they reached the barrier.
+	struct ip_spin_barrier_node_t
+	{
+		/// The last barrier episode that the partner of every round reached. The flags are contiguous, the node as a whole starting on its own cache line so that no two threads share one.
+		_Alignas(IP_CACHE_LINE_SIZE) atomic_size_t flags[IP_SPIN_BARRIER_MAX_ROUNDS];
+		/// The number of barriers the thread went through, only accessed by the thread itself.
+		size_t episode;
+	};
+	/// The number of rounds of the dissemination barrier, that is the base 2 logarithm of the number of threads rounded up.
+	int ip_spin_barrier_rounds = 0;
+	/// The nodes of all threads.
+	struct ip_spin_barrier_node_t* ip_all_spin_barrier_nodes = NULL;
+	/**
+	 * @brief This function allocates the nodes of the spinning barrier.
+	 * @pre The number of threads is known.
+	 **/
+	void ip_init_spin_barrier();
+	/**
+	 * @brief This function waits until all threads of the team have called it.
+	 * @details It is a dissemination barrier: at round k, thread i notifies
+	 * thread i + 2^k and waits for thread i - 2^k, so every thread only spins
+	 * on its own cache lines and the barrier completes after
+	 * ip_spin_barrier_rounds rounds, without any atomic read-modify-write.
+	 * Unlike OpenMP barriers, threads never go to sleep, which keeps the cost
+	 * of a barrier in the order of a microsecond as long as there is a core
+	 * per thread.
+	 * @post All memory operations that threads performed before the barrier
+	 * are visible to all threads after it.
+	 **/
+	void ip_spin_barrier();
+#endif // ifdef IP_USE_SPIN_BARRIER
+
+/******************
+ * HUB BROADCASTS *
+ ******************/
+#ifdef IP_USE_HUB_BROADCASTS
+	#ifndef IP_HUB_DEGREE_THRESHOLD
+		/// The number of out-neighbours from which the broadcasts of a vertex are shared between threads.
+		#define IP_HUB_DEGREE_THRESHOLD 65536
+	#endif // ifndef IP_HUB_DEGREE_THRESHOLD
+	#ifndef IP_HUB_CHUNK_SIZE
+		/// The number of out-neighbours that a thread claims at once from a hub broadcast.
+		#define IP_HUB_CHUNK_SIZE 4096
+	#endif // ifndef IP_HUB_CHUNK_SIZE
+	/// A broadcast that a hub deferred until the end of the compute phase.
+	struct ip_hub_broadcast_t
+	{
+		/// The hub that broadcasts.
+		struct ip_vertex_t* vertex;
+		/// The message to send to all its out-neighbours.
+		IP_MESSAGE_TYPE message;
+	};
+	/// The number of vertices having at least IP_HUB_DEGREE_THRESHOLD out-neighbours, which is also the capacity of ip_hub_broadcasts.
+	size_t ip_hubs_count = 0;
+	/// The broadcasts deferred during the current superstep.
+	struct ip_hub_broadcast_t* ip_hub_broadcasts = NULL;
+	/// The number of broadcasts deferred during the current superstep.
+	atomic_size_t ip_hub_broadcasts_count;
+	/// The next chunk of out-neighbours to claim, numbered across all broadcasts deferred.
+	atomic_size_t ip_hub_next_chunk;
+	/**
+	 * @brief This function counts the hubs of the graph and allocates room for
+	 * their broadcasts.
+	 * @pre The graph is loaded.
+	 **/
+	void ip_init_hub_broadcasts();
+	/**
+	 * @brief This function defers the broadcast of \p message by \p v if
+	 * \p v is a hub.
+	 * @param[in] v The vertex broadcasting.
+	 * @param[in] message The message to broadcast.
+	 * @retval true The broadcast is deferred and will be sent by
+	 * ip_run_hub_broadcasts().
+	 * @retval false The vertex must broadcast the message itself.
+	 **/
+	bool ip_defer_hub_broadcast(struct ip_vertex_t* v, IP_MESSAGE_TYPE message);
+	/**
+	 * @brief This function sends the chunks of deferred broadcasts that the
+	 * calling thread manages to claim, until none is left.
+	 * @param[in] hub_broadcasts_count The number of broadcasts deferred.
+	 **/
+	void ip_send_hub_broadcast_chunks(size_t hub_broadcasts_count);
+	/**
+	 * @brief This function sends the broadcasts deferred during the compute
+	 * phase, all threads claiming chunks of IP_HUB_CHUNK_SIZE out-neighbours
+	 * until none is left.
+	 * @details This function contains an OpenMP barrier when broadcasts were
+	 * deferred and must therefore be called by all threads of the team.
+	 * @pre All threads are done computing the current superstep.
+	 * @post All deferred broadcasts are sent and none is deferred anymore.
+	 **/
+	void ip_run_hub_broadcasts();
+	/**
+	 * @brief This function sends, on the calling thread alone, the broadcasts
+	 * deferred during the compute phase.
+	 * @pre The calling thread is the only one running.
+	 * @post All deferred broadcasts are sent and none is deferred anymore.
+	 **/
+	void ip_run_hub_broadcasts_alone();
+	/**
+	 * @brief This function releases the room allocated by
+	 * ip_init_hub_broadcasts().
+	 * @pre No broadcast is deferred anymore.
+	 **/
+	void ip_free_hub_broadcasts();
+#endif // ifdef IP_USE_HUB_BROADCASTS
+
+/*****************
+ * HUB MAILBOXES *
+ *****************/
+#ifdef IP_USE_HUB_MAILBOXES
+	#ifndef IP_HUB_IN_DEGREE_THRESHOLD
+		/// The number of in-neighbours from which a vertex receives its messages in per-thread partial mailboxes.
+		#define IP_HUB_IN_DEGREE_THRESHOLD 65536
+	#endif // ifndef IP_HUB_IN_DEGREE_THRESHOLD
+	/// The partial mailbox that a thread has for a hub, written by that thread only.
+	struct ip_hub_mailbox_t
+	{
+		/// The combination of the messages the thread sent to the hub.
+		IP_MESSAGE_TYPE message;
+		/// Indicates whether message holds anything.
+		bool full;
+	};
+	/// The number of vertices having at least IP_HUB_IN_DEGREE_THRESHOLD in-neighbours.
+	size_t ip_hub_mailboxes_count = 0;
+	/// The identifiers of the vertices having partial mailboxes, in increasing order.
+	IP_VERTEX_ID_TYPE* ip_hub_mailbox_ids = NULL;
+	/// One bit per vertex location, set if the vertex has partial mailboxes.
+	uint64_t* ip_hub_mailbox_bitmap = NULL;
+	/// The partial mailboxes of every thread, indexed like ip_hub_mailbox_ids.
+	struct ip_hub_mailbox_t** ip_all_hub_mailboxes = NULL;
+	/// Indicates whether a partial mailbox was written during the current superstep.
+	atomic_bool ip_hub_mailboxes_filled;
+	/**
+	 * @brief This function finds the vertices having at least
+	 * IP_HUB_IN_DEGREE_THRESHOLD in-neighbours and allocates their partial
+	 * mailboxes.
+	 * @pre The graph is loaded and the number of threads is known.
+	 **/
+	void ip_init_hub_mailboxes();
+	/**
+	 * @brief This function checks whether the vertex \p id receives its
+	 * messages in partial mailboxes.
+	 * @param[in] id The identifier of the vertex.
+	 * @retval true The vertex has partial mailboxes.
+	 * @retval false The vertex has its single mailbox only.
+	 **/
+	bool ip_has_hub_mailboxes(IP_VERTEX_ID_TYPE id);
+	/**
+	 * @brief This function combines the message \p message into the partial
+	 * mailbox that the calling thread has for the vertex \p id, without any
+	 * atomic operation.
+	 * @param[in] id The identifier of the recipient.
+	 * @param[in] message The message to deliver.
+	 * @pre ip_has_hub_mailboxes() returns true for \p id.
+	 **/
+	void ip_deliver_to_hub_mailbox(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message);
+	/**
+	 * @brief This function combines the partial mailboxes of the hub
+	 * \p hub and delivers the result with ip_deliver_binned_message().
+	 * @param[in] hub The index of the hub in ip_hub_mailbox_ids.
+	 * @post The partial mailboxes of that hub are empty.
+	 **/
+	void ip_combine_hub_mailboxes_of(size_t hub);
+	/**
+	 * @brief This function combines the partial mailboxes of every hub into its
+	 * mailbox, each hub being handled by a single thread.
+	 * @details This function contains an OpenMP for construct when a partial
+	 * mailbox was written and must therefore be called by all threads of the
+	 * team.
+	 * @pre All threads are done sending messages for the current superstep.
+	 * @post All partial mailboxes are empty.
+	 **/
+	void ip_combine_hub_mailboxes();
+	/**
+	 * @brief This function combines, on the calling thread alone, the partial
+	 * mailboxes of every hub into its mailbox.
+	 * @pre The calling thread is the only one running.
+	 * @post All partial mailboxes are empty.
+	 **/
+	void ip_combine_hub_mailboxes_alone();
+	/**
+	 * @brief This function releases the partial mailboxes and the lookup
+	 * structures allocated by ip_init_hub_mailboxes().
+	 * @pre All partial mailboxes are empty.
+	 **/
+	void ip_free_hub_mailboxes();
+#endif // ifdef IP_USE_HUB_MAILBOXES
+
+/***************
+ * AGGREGATORS *
+ ***************/
+#ifndef IP_MAX_AGGREGATORS
+	/// The maximum number of aggregators an application can register.
+	#define IP_MAX_AGGREGATORS 8
+#endif // ifndef IP_MAX_AGGREGATORS
+/// The reductions an aggregator can apply to the values it receives.
+enum ip_aggregator_operation_t
+{
+	/// The aggregator sums the values it receives.
+	IP_AGGREGATOR_SUM,
+	/// The aggregator keeps the smallest value it receives.
+	IP_AGGREGATOR_MIN,
+	/// The aggregator keeps the largest value it receives.
+	IP_AGGREGATOR_MAX
+};
+/// This structure holds the values a thread aggregated so far during the current superstep.
+struct ip_aggregator_partials_t
+{
+	/// The partial value of every aggregator, kept on cache lines of its own.
+	_Alignas(IP_CACHE_LINE_SIZE) double values[IP_MAX_AGGREGATORS];
+};
+/// The number of aggregators registered.
+size_t ip_aggregators_count = 0;
+/// The reduction applied by every aggregator registered.
+enum ip_aggregator_operation_t ip_aggregator_operations[IP_MAX_AGGREGATORS];
+/// The value of every aggregator, as reduced at the end of last superstep.
+double ip_aggregator_values[IP_MAX_AGGREGATORS];
+/// The partial values of all threads.
+struct ip_aggregator_partials_t* ip_all_aggregator_partials = NULL;
+/**
+ * @brief This function returns the value that leaves any value unchanged when
+ * reduced with it by the operation \p operation.
+ * @param[in] operation The reduction.
+ * @return The identity of the reduction.
+ **/
+double ip_get_aggregator_identity(enum ip_aggregator_operation_t operation);
+/**
+ * @brief This function registers a new aggregator.
+ * @details Vertices contribute to an aggregator with ip_aggregate() during a
+ * superstep, and the values contributed are reduced at the end of that
+ * superstep. The result can be read during the next superstep with
+ * ip_get_aggregated_value().
+ * @param[in] operation The reduction applied to the values contributed.
+ * @return The identifier of the aggregator.
+ * @pre ip_init() has been called.
+ **/
+size_t ip_register_aggregator(enum ip_aggregator_operation_t operation);
+/**
+ * @brief This function contributes the value \p value to the aggregator
+ * \p aggregator.
+ * @details The value is combined into a partial value private to the calling
+ * thread, so no synchronisation is involved.
+ * @param[in] aggregator The identifier of the aggregator.
+ * @param[in] value The value to contribute.
+ **/
+void ip_aggregate(size_t aggregator, double value);
+/**
+ * @brief This function returns the value of the aggregator \p aggregator as
+ * reduced at the end of last superstep.
+ * @details During the first superstep, it returns the identity of the
+ * reduction, that is 0 for a sum, +infinity for a minimum and -infinity for a
+ * maximum.
+ * @param[in] aggregator The identifier of the aggregator.
+ * @return The value of the aggregator.
+ **/
+double ip_get_aggregated_value(size_t aggregator);
+/**
+ * @brief This function reduces the partial values of all threads and resets
+ * them for the next superstep.
+ * @pre All threads are done computing the current superstep.
+ * @post ip_get_aggregated_value() returns the values reduced.
+ **/
+void ip_reduce_aggregators();
+
+/*****************
+ * REMOTE VALUES *
+ *****************/
+#ifdef IP_NEEDS_REMOTE_VALUES
+	#ifdef IP_USE_ASYNCHRONOUS
+		#error The asynchronous version has no superstep boundary at which values could be committed, it does not support IP_NEEDS_REMOTE_VALUES.
+	#endif // ifdef IP_USE_ASYNCHRONOUS
+	/// The value of every vertex, indexed by location, as committed at the end of last superstep.
+	IP_VALUE_TYPE* ip_committed_values = NULL;
+	/**
+	 * @brief This function returns the value that the vertex \p id had at the
+	 * end of last superstep.
+	 * @details Any vertex can read the value of any other vertex, which is what
+	 * pointer-jumping algorithms need. Since the value returned is the one
+	 * committed at the end of last superstep, it does not depend on the order
+	 * in which vertices are computed during the current superstep.
+	 * @param[in] id The identifier of the vertex to read.
+	 * @return The value of vertex \p id at the end of last superstep.
+	 * @pre The current superstep is not the first one, there is no value
+	 * committed yet during the first superstep.
+	 **/
+	IP_VALUE_TYPE ip_get_value_of(IP_VERTEX_ID_TYPE id);
+	/**
+	 * @brief This function copies the value of every vertex into
+	 * ip_committed_values.
+	 * @details This function contains an OpenMP for construct and must therefore
+	 * be called by all threads of the team.
+	 * @pre All threads are done computing the current superstep.
+	 * @post ip_get_value_of() returns the values of the current superstep once
+	 * the implicit barrier of the for construct is passed.
+	 **/
+	void ip_commit_values();
+#endif // ifdef IP_NEEDS_REMOTE_VALUES
+
 /******************
  * SAFE FUNCTIONS *
  ******************/
@@ -192,6 +916,17 @@ void ip_load_graph(const char* file_path, bool directed, bool weighted);
  * bytes.
  **/
 void* ip_safe_malloc(size_t size_to_malloc);
+/**
+ * @brief This function allocates a memory area aligned on \p alignment bytes
+ * and checks the memory area was successfully allocated, otherwise exits the
+ * program.
+ * @param[in] alignment The alignment required, in bytes.
+ * @param[in] size_to_malloc The size to allocate, in bytes. It is rounded up
+ * to a multiple of \p alignment.
+ * @return A pointer on the memory area allocated, which can be freed with
+ * ip_safe_free().
+ **/
+void* ip_safe_aligned_malloc(size_t alignment, size_t size_to_malloc);
 /**
  * @brief This function executes a realloc and checks that it succeeded, 
  * otherwise exits the program.
@@ -290,8 +1025,8 @@ extern void ip_compute(struct ip_vertex_t* v);
  * iPregel.
  * @param[in] file_path Path leading to the file containing the graph. If a graph myGraph contains the files myGraph.config, myGraph.idx and myGraph.adj, it is "myGraph" that should be passed to this function.
  * @param[in] number_of_threads The number of threads to use.
- * @param[in] schedule The OpenMP schedule to apply in graphd loading and vertex processing. This helps ensuring that vertices are processed on the same thread they were loaded.
- * @param[in] chunk_size The chunk size to assign to the OpenMP schedule passed. Can be 0 to represent the default chunk size.
+ * @param[in] schedule The OpenMP schedule to apply in graphd loading and vertex processing. This helps ensuring that vertices are processed on the same thread they were loaded. It can also be "edge_stealing" to process vertices in chunks of similar edge count that idle threads steal from others.
+ * @param[in] chunk_size The chunk size to assign to the OpenMP schedule passed. Can be 0 to represent the default chunk size. With "edge_stealing", it is the number of chunks per thread instead.
  * @param[in] directed Indicates whether the graph to load contains directed or undirected edges.
  * @param[in] weighted Indicates whether the graph to load contains weighted or unweighted edges.
  **/
@@ -301,6 +1036,27 @@ void ip_init(const char* file_path, int number_of_threads, const char* schedule,
  * @details This function is distinct from the global initialisation ip_init().
  **/
 extern void ip_init_specific();
+/**
+ * @brief This function gives the locations of the vertices that the thread
+ * \p thread_num initialises, the vertices being split into as many contiguous
+ * blocks of equal size as there are threads.
+ * @param[in] thread_num The thread number in the OpenMP team.
+ * @param[out] first The location of the first vertex of the block.
+ * @param[out] last The location following that of the last vertex of the block.
+ **/
+void ip_get_vertex_block(int thread_num, size_t* first, size_t* last);
+/**
+ * @brief This function allocates the context of every thread and lets each
+ * thread initialise its own, so that its pages are placed near that thread.
+ * It also allocates the aggregator partial values of every thread.
+ **/
+void ip_init_thread_contexts();
+/**
+ * @brief This function is implemented by underlying iPregel version to
+ * initialise the context of the calling thread.
+ * @param[out] context The context to initialise.
+ **/
+extern void ip_init_thread_context(struct ip_thread_context_t* context);
 /**
  * @brief This function acts as the start point of the iPregel simulation.
  * @return The error code.
@@ -316,18 +1072,26 @@ extern int ip_run();
  **/
 void ip_dump(FILE* f);
 	
-#ifdef IP_USE_SPREAD
+#if defined(IP_WITHOUT_COMBINER)
+	#include "no_combiner_preamble.h"
+#elif defined(IP_USE_ASYNCHRONOUS)
+	#include "combiner_asynchronous_preamble.h"
+#elif defined(IP_USE_BLOCK_CENTRIC)
+	#include "combiner_block_centric_preamble.h"
+#elif defined(IP_USE_HYBRID)
+	#include "combiner_hybrid_preamble.h"
+#elif defined(IP_USE_SPREAD)
 	#ifdef IP_USE_SINGLE_BROADCAST
 		#include "combiner_spread_single_broadcast_preamble.h"
 	#else // ifndef IP_USE_SINGLE_BROADCAST
 		#include "combiner_spread_preamble.h"
 	#endif // if(n)def IP_USE_SINGLE_BROADCAST
-#else // ifndef IP_USE_SPREAD
+#else // if !defined(IP_USE_HYBRID) && !defined(IP_USE_SPREAD)
 	#ifdef IP_USE_SINGLE_BROADCAST
 		#include "combiner_single_broadcast_preamble.h"
 	#else // ifndef IP_USE_SINGLE_BROADCAST
 		#include "combiner_preamble.h"
 	#endif // if(n)def IP_USE_SINGLE_BROADCAST
-#endif // if(n)def IP_USE_SPREAD
+#endif // if defined(IP_WITHOUT_COMBINER)
 
 #endif // MY_PREGEL_PREAMBLE_H_INCLUDED
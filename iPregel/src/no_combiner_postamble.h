@@ -0,0 +1,320 @@
+/**
+ * @file no_combiner_postamble.h
+ * @copyright Copyright (C) 2019 Ludovic Capelli
+ * @par License
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ * @author Ludovic Capelli
+ **/
+
+#ifndef NO_COMBINER_POSTAMBLE_H_INCLUDED
+#define NO_COMBINER_POSTAMBLE_H_INCLUDED
+
+#include <omp.h>
+#include <string.h>
+
+bool ip_has_message(struct ip_vertex_t* v)
+{
+	return v->next_message < ip_inbox_offsets[v - ip_get_vertex_by_location(0) + 1];
+}
+
+bool ip_get_next_message(struct ip_vertex_t* v, IP_MESSAGE_TYPE* message_value)
+{
+	if(ip_has_message(v))
+	{
+		*message_value = ip_inbox_messages[v->next_message];
+		v->next_message++;
+		return true;
+	}
+
+	return false;
+}
+
+void ip_send_message(IP_VERTEX_ID_TYPE id, IP_MESSAGE_TYPE message)
+{
+	struct ip_outbox_t* my_outbox = &ip_all_thread_contexts[ip_my_thread_num].outbox;
+	if(my_outbox->size == my_outbox->max_size)
+	{
+		my_outbox->max_size = my_outbox->max_size == 0 ? 64 : my_outbox->max_size * 2;
+		my_outbox->data = ip_safe_realloc(my_outbox->data, sizeof(struct ip_outgoing_message_t) * my_outbox->max_size);
+	}
+
+	my_outbox->data[my_outbox->size].location = ip_get_vertex_by_id(id) - ip_get_vertex_by_location(0);
+	my_outbox->data[my_outbox->size].message = message;
+	my_outbox->size++;
+}
+
+void ip_broadcast(struct ip_vertex_t* v, IP_MESSAGE_TYPE message)
+{
+	#ifdef IP_USE_HUB_BROADCASTS
+		if(ip_defer_hub_broadcast(v, message))
+		{
+			return;
+		}
+	#endif // ifdef IP_USE_HUB_BROADCASTS
+	for(IP_NEIGHBOUR_COUNT_TYPE i = 0; i < v->out_neighbour_count; i++)
+	{
+		ip_send_message(v->out_neighbours[i], message);
+	}
+}
+
+void ip_compute_vertex_at(size_t location)
+{
+	struct ip_vertex_t* temp_vertex = ip_get_vertex_by_location(location);
+	if(temp_vertex->active || ip_has_message(temp_vertex))
+	{
+		temp_vertex->active = true;
+		ip_compute(temp_vertex);
+		if(temp_vertex->active)
+		{
+			ip_all_thread_contexts[ip_my_thread_num].active_vertices_count++;
+		}
+	}
+}
+
+void ip_build_inbox()
+{
+	struct ip_thread_context_t* my_context = &ip_all_thread_contexts[ip_my_thread_num];
+
+	// Count the messages of the outbox going to every bucket.
+	memset(my_context->bucket_positions, 0, sizeof(size_t) * ip_inbox_buckets_count);
+	for(size_t i = 0; i < my_context->outbox.size; i++)
+	{
+		my_context->bucket_positions[my_context->outbox.data[i].location / IP_INBOX_BUCKET_RANGE]++;
+	}
+
+	#pragma omp barrier
+	#pragma omp single
+	{
+		// Buckets follow each other, and inside a bucket the messages of a thread follow those of the threads before it.
+		size_t position = 0;
+		for(size_t i = 0; i < ip_inbox_buckets_count; i++)
+		{
+			ip_inbox_bucket_starts[i] = position;
+			for(int j = 0; j < ip_thread_count; j++)
+			{
+				size_t count = ip_all_thread_contexts[j].bucket_positions[i];
+				ip_all_thread_contexts[j].bucket_positions[i] = position;
+				position += count;
+			}
+		}
+		ip_inbox_bucket_starts[ip_inbox_buckets_count] = position;
+		ip_inbox_offsets[ip_get_vertices_count()] = position;
+		ip_messages_count = position;
+		if(ip_inbox_max_size < ip_messages_count)
+		{
+			// The content of the buffers is not needed anymore, freeing them saves the copy a realloc would make.
+			ip_inbox_max_size = ip_inbox_max_size * 2 < ip_messages_count ? ip_messages_count : ip_inbox_max_size * 2;
+			ip_safe_free(ip_bucketed_messages);
+			ip_safe_free(ip_inbox_messages);
+			ip_bucketed_messages = (struct ip_outgoing_message_t*)ip_safe_malloc(sizeof(struct ip_outgoing_message_t) * ip_inbox_max_size);
+			ip_inbox_messages = (IP_MESSAGE_TYPE*)ip_safe_malloc(sizeof(IP_MESSAGE_TYPE) * ip_inbox_max_size);
+		}
+	}
+
+	// Scatter the outbox into the buckets.
+	for(size_t i = 0; i < my_context->outbox.size; i++)
+	{
+		size_t bucket = my_context->outbox.data[i].location / IP_INBOX_BUCKET_RANGE;
+		ip_bucketed_messages[my_context->bucket_positions[bucket]] = my_context->outbox.data[i];
+		my_context->bucket_positions[bucket]++;
+	}
+	my_context->outbox.size = 0;
+
+	#pragma omp barrier
+	// Sort every bucket by recipient; a bucket is handled by a single thread so its counters need no atomics.
+	#pragma omp for schedule(dynamic, 1)
+	for(size_t i = 0; i < ip_inbox_buckets_count; i++)
+	{
+		size_t first_recipient = i * IP_INBOX_BUCKET_RANGE;
+		size_t recipients_count = ip_get_vertices_count() - first_recipient < IP_INBOX_BUCKET_RANGE ? ip_get_vertices_count() - first_recipient : IP_INBOX_BUCKET_RANGE;
+		size_t* recipient_positions = my_context->recipient_positions;
+		memset(recipient_positions, 0, sizeof(size_t) * recipients_count);
+		for(size_t j = ip_inbox_bucket_starts[i]; j < ip_inbox_bucket_starts[i + 1]; j++)
+		{
+			recipient_positions[ip_bucketed_messages[j].location - first_recipient]++;
+		}
+
+		size_t position = ip_inbox_bucket_starts[i];
+		for(size_t j = 0; j < recipients_count; j++)
+		{
+			size_t count = recipient_positions[j];
+			recipient_positions[j] = position;
+			ip_inbox_offsets[first_recipient + j] = position;
+			ip_get_vertex_by_location(first_recipient + j)->next_message = position;
+			position += count;
+		}
+
+		for(size_t j = ip_inbox_bucket_starts[i]; j < ip_inbox_bucket_starts[i + 1]; j++)
+		{
+			size_t recipient = ip_bucketed_messages[j].location - first_recipient;
+			ip_inbox_messages[recipient_positions[recipient]] = ip_bucketed_messages[j].message;
+			recipient_positions[recipient]++;
+		}
+	}
+}
+
+void ip_init_vertex_range(IP_VERTEX_ID_TYPE first, IP_VERTEX_ID_TYPE last)
+{
+	for(IP_VERTEX_ID_TYPE i = first; i <= last; i++)
+	{
+		ip_all_vertices[i].id = i;
+		ip_all_vertices[i].active = true;
+		ip_all_vertices[i].next_message = 0;
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+			ip_all_vertices[i].out_neighbour_count = 0;
+		#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_IDS
+			ip_all_vertices[i].out_neighbours = NULL;
+		#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_IDS
+		#ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+			ip_all_vertices[i].out_neighbour_weights = NULL;
+		#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+			ip_all_vertices[i].in_neighbours = NULL;
+		#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_COUNT
+			ip_all_vertices[i].in_neighbour_count = 0;
+		#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_COUNT
+		#ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+			ip_all_vertices[i].in_neighbour_weights = NULL;
+		#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHT
+	}
+}
+
+void ip_init_thread_context(struct ip_thread_context_t* context)
+{
+	context->active_vertices_count = 0;
+	context->outbox.max_size = 0;
+	context->outbox.size = 0;
+	context->outbox.data = NULL;
+	context->bucket_positions = (size_t*)ip_safe_malloc(sizeof(size_t) * ((ip_get_vertices_count() + IP_INBOX_BUCKET_RANGE - 1) / IP_INBOX_BUCKET_RANGE));
+	context->recipient_positions = (size_t*)ip_safe_malloc(sizeof(size_t) * IP_INBOX_BUCKET_RANGE);
+}
+
+void ip_init_specific()
+{
+	ip_inbox_buckets_count = (ip_get_vertices_count() + IP_INBOX_BUCKET_RANGE - 1) / IP_INBOX_BUCKET_RANGE;
+	ip_inbox_bucket_starts = (size_t*)ip_safe_malloc(sizeof(size_t) * (ip_inbox_buckets_count + 1));
+	// Nobody has messages at superstep 0.
+	ip_inbox_offsets = (size_t*)ip_safe_malloc(sizeof(size_t) * (ip_get_vertices_count() + 1));
+	memset(ip_inbox_offsets, 0, sizeof(size_t) * (ip_get_vertices_count() + 1));
+}
+
+int ip_run()
+{
+	double timer_superstep_total = 0;
+	double timer_superstep_start = 0;
+	double timer_superstep_stop = 0;
+
+	#pragma omp parallel default(none) shared(ip_active_vertices, \
+											  ip_messages_count, \
+											  ip_use_edge_stealing, \
+											  ip_all_thread_contexts, \
+											  ip_thread_count, \
+											  timer_superstep_total, \
+											  timer_superstep_start, \
+											  timer_superstep_stop)
+	{
+		ip_my_thread_num = omp_get_thread_num();
+		while(ip_active_vertices != 0 || ip_messages_count != 0)
+		{
+			// This barrier is crucial; otherwise a thread may enter the single, change ip_active_vertices before one other thread has entered the loop. Thus the single would never complete.
+			#pragma omp barrier
+
+			//////////////////
+			// START TIMER //
+			////////////////
+			// This OpenMP single also acts as an implicit barrier to wait for all threads before they start processing a superstep.
+			#pragma omp single
+			{
+				timer_superstep_start = omp_get_wtime();
+				ip_active_vertices = 0;
+			}
+
+			////////////////////
+			// COMPUTE PHASE //
+			//////////////////
+			if(ip_use_edge_stealing)
+			{
+				size_t chunk_first;
+				size_t chunk_last;
+				ip_prepare_chunks(NULL, ip_get_vertices_count());
+				while(ip_get_next_chunk(&chunk_first, &chunk_last))
+				{
+					for(size_t i = chunk_first; i < chunk_last; i++)
+					{
+						ip_compute_vertex_at(i);
+					}
+				}
+				// Replaces the implicit barrier of the OpenMP for below.
+				#pragma omp barrier
+			}
+			else
+			{
+				#pragma omp for schedule(runtime)
+				for(size_t i = 0; i < ip_get_vertices_count(); i++)
+				{
+					ip_compute_vertex_at(i);
+				}
+			}
+
+			#ifdef IP_USE_HUB_BROADCASTS
+				//////////////////////////
+				// HUB BROADCAST PHASE //
+				////////////////////////
+				ip_run_hub_broadcasts();
+			#endif // ifdef IP_USE_HUB_BROADCASTS
+
+			///////////////////////////
+			// INBOX BUILDING PHASE //
+			/////////////////////////
+			ip_build_inbox();
+
+			#ifdef IP_NEEDS_REMOTE_VALUES
+				ip_commit_values();
+			#endif // ifdef IP_NEEDS_REMOTE_VALUES
+
+			// The implicit barrier of the OpenMP for ending the phase above guarantees that all threads are done.
+			#pragma omp single
+			{
+				for(int i = 0; i < ip_thread_count; i++)
+				{
+					ip_active_vertices += ip_all_thread_contexts[i].active_vertices_count;
+					ip_all_thread_contexts[i].active_vertices_count = 0;
+				}
+				timer_superstep_stop = omp_get_wtime();
+				timer_superstep_total += timer_superstep_stop - timer_superstep_start;
+				printf("Superstep%zuDuration:%f\n", ip_get_superstep(), timer_superstep_stop - timer_superstep_start);
+				printf("Superstep%zuActiveVertexCount:%zu\n", ip_get_superstep(), ip_active_vertices);
+				printf("Superstep%zuMessageCount:%zu\n", ip_get_superstep(), ip_messages_count);
+				ip_reduce_aggregators();
+				ip_increment_superstep();
+ 			} // End of OpenMP single region
+		} // End of superstep processing loop
+ 	} // End of OpenMP region
+
+	printf("Total time of supersteps: %fs.\n", timer_superstep_total);
+
+	// Free and clean program.
+	#ifdef IP_USE_HUB_BROADCASTS
+		ip_free_hub_broadcasts();
+	#endif // ifdef IP_USE_HUB_BROADCASTS
+
+	return 0;
+}
+
+void ip_vote_to_halt(struct ip_vertex_t* v)
+{
+	v->active = false;
+}
+
+#endif // NO_COMBINER_POSTAMBLE_H_INCLUDED
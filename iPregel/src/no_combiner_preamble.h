@@ -0,0 +1,148 @@
+/**
+ * @file no_combiner_preamble.h
+ * @copyright Copyright (C) 2019 Ludovic Capelli
+ * @par License
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ * @author Ludovic Capelli
+ * @brief This version delivers every message individually, without combining.
+ * @details This version is meant for the algorithms that need every message
+ * received, such as label propagation. During a superstep, the messages sent
+ * by a thread are appended to an outbox of its own. Between supersteps, the
+ * outboxes are sorted by recipient with a parallel counting sort into a single
+ * inbox laid out like a compressed sparse row: the messages of every vertex are
+ * contiguous, and a vertex reads them one after the other. All buffers are
+ * reused from one superstep to the next, so no memory is allocated per message.
+ * The counting sort works in two passes so that threads never need atomic
+ * operations:
+ * - the outboxes are first scattered into buckets, each covering
+ * IP_INBOX_BUCKET_RANGE consecutive vertices.
+ * - every bucket is then sorted by recipient by a single thread.
+ **/
+
+#ifndef NO_COMBINER_PREAMBLE_H_INCLUDED
+#define NO_COMBINER_PREAMBLE_H_INCLUDED
+
+#ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
+	#define IP_NEEDS_OUT_NEIGHBOUR_IDS
+#endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_IDS
+
+#ifndef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+	#define IP_NEEDS_OUT_NEIGHBOUR_COUNT
+#endif // ifndef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+
+#ifndef IP_INBOX_BUCKET_RANGE
+	/// The number of consecutive recipients covered by a bucket of the counting sort; the per-recipient counters of a bucket should fit in cache.
+	#define IP_INBOX_BUCKET_RANGE 32768
+#endif // ifndef IP_INBOX_BUCKET_RANGE
+
+// Global variables
+/// This structure defines the structure of a vertex.
+struct ip_vertex_t
+{
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_IDS
+		/// Contains the identifiers of the out-neighbours
+		IP_VERTEX_ID_TYPE* out_neighbours;
+	#endif // IP_NEEDS_OUT_NEIGHBOUR_IDS
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+		/// Contains the identifiers of the in-neighbours
+		IP_VERTEX_ID_TYPE* in_neighbours;
+	#endif // ifdef IP_NEEDS_IN_NEIGHBOUR_IDS
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+		/// Contains the number of out-neighbours
+		IP_NEIGHBOUR_COUNT_TYPE out_neighbour_count;
+	#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_COUNT
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_COUNT
+		/// Contains the number of in-neighbours
+		IP_NEIGHBOUR_COUNT_TYPE in_neighbour_count;
+	#endif // IP_NEEDS_IN_NEIGHBOUR_COUNT
+	#ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+		/// Contains the weights of out-edges
+		IP_EDGE_WEIGHT_TYPE* out_neighbour_weights;
+	#endif // ifdef IP_NEEDS_OUT_NEIGHBOUR_WEIGHTS
+	#ifdef IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+		/// Contains the weights of the in-neighbours
+		IP_EDGE_WEIGHT_TYPE* in_neighbour_weights;
+	#endif // IP_NEEDS_IN_NEIGHBOUR_WEIGHTS
+	/// Contains the vertex status
+	bool active;
+	/// Contains the vertex identifier
+	IP_VERTEX_ID_TYPE id;
+	/// The position in the inbox of the next message to read
+	size_t next_message;
+	/// Contains the user-defined value
+	IP_VALUE_TYPE value;
+};
+/// A message waiting in an outbox or a bucket until it is sorted into the inbox.
+struct ip_outgoing_message_t
+{
+	/// The location of the recipient.
+	IP_VERTEX_ID_TYPE location;
+	/// The message to deliver.
+	IP_MESSAGE_TYPE message;
+};
+/// This structure holds the messages that a thread sent during the current superstep.
+struct ip_outbox_t
+{
+	/// The size of the memory buffer. It is used for reallocation purpose.
+	size_t max_size;
+	/// The number of messages currently stored.
+	size_t size;
+	/// The actual messages.
+	struct ip_outgoing_message_t* data;
+};
+/// This structure holds the data that a thread uses during a superstep.
+struct ip_thread_context_t
+{
+	/// The number of vertices that the thread executed and that are still active.
+	_Alignas(IP_CACHE_LINE_SIZE) size_t active_vertices_count;
+	/// The messages the thread sent during the current superstep.
+	struct ip_outbox_t outbox;
+	/// The number of messages in the outbox for every bucket, then the position at which the thread writes them in the buckets.
+	size_t* bucket_positions;
+	/// The position at which the next message of each recipient of a bucket goes in the inbox, IP_INBOX_BUCKET_RANGE elements.
+	size_t* recipient_positions;
+};
+/// The number of buckets used by the counting sort.
+size_t ip_inbox_buckets_count = 0;
+/// The position of the first message of every bucket, followed by the total number of messages.
+size_t* ip_inbox_bucket_starts = NULL;
+/// The messages scattered into buckets, waiting to be sorted into the inbox.
+struct ip_outgoing_message_t* ip_bucketed_messages = NULL;
+/// The messages of all vertices, those of a vertex being contiguous.
+IP_MESSAGE_TYPE* ip_inbox_messages = NULL;
+/// The capacity of ip_bucketed_messages and ip_inbox_messages.
+size_t ip_inbox_max_size = 0;
+/// The position in the inbox of the first message of every vertex, followed by the total number of messages.
+size_t* ip_inbox_offsets = NULL;
+/// The number of messages sent during the last superstep.
+size_t ip_messages_count = 0;
+
+/**
+ * @brief This function executes the vertex at location \p location if it is
+ * active or has messages.
+ * @param[in] location The location of the vertex.
+ * @post The active_vertices_count of the calling thread is incremented if the
+ * vertex is still active after being executed.
+ **/
+void ip_compute_vertex_at(size_t location);
+/**
+ * @brief This function sorts the messages of all outboxes by recipient into
+ * the inbox.
+ * @details This function contains OpenMP for constructs and barriers and must
+ * therefore be called by all threads of the team.
+ * @pre All threads are done sending messages.
+ * @post The inbox contains the messages sent, all outboxes are empty and
+ * ip_messages_count contains the number of messages sent.
+ **/
+void ip_build_inbox();
+
+#endif // NO_COMBINER_PREAMBLE_H_INCLUDED